@@ -0,0 +1,79 @@
+// Compares the box cascade and the recursive Gaussian blur: time per pass over a large
+// buffer and width of the impulse response against the requested radius.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "tv/tvmath.h"
+
+namespace {
+    constexpr int SIZE = 2048;
+    constexpr int RUNS = 5;
+
+    template<typename Blur>
+    double bestMs(std::vector<int>& data, const std::vector<int>& source, const Blur& blur) {
+        double best = 1e30;
+        for (int i = 0; i < RUNS; i++) {
+            std::copy(source.begin(), source.end(), data.begin());
+            const auto start = std::chrono::steady_clock::now();
+            blur(data.data());
+            const std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+            best = std::min(best, ms.count());
+        }
+        return best;
+    }
+
+    // standard deviation of the response to a line impulse, in 1D the tails don't round away to zero
+    template<typename Blur>
+    double impulseWidth(const int radius, const Blur& blur) {
+        // the box cascade needs the data to be larger than the kernel in both directions
+        const int w = 12 * radius + 21;
+        const int h = w;
+        std::vector<int> data(static_cast<std::size_t>(w) * h);
+        for (int i = 0; i < h; i++) {
+            data[static_cast<std::size_t>(i) * w + w / 2] = 1 << 24;
+        }
+        blur(data.data(), w, h);
+        double mass = 0;
+        double var = 0;
+        for (int j = 0; j < w; j++) {
+            const double v = data[j];
+            mass += v;
+            var += v * (j - w / 2) * (j - w / 2);
+        }
+        return std::sqrt(var / mass);
+    }
+}
+
+int main() {
+    using namespace TV::Math;
+    std::vector<int> source(static_cast<std::size_t>(SIZE) * SIZE);
+    unsigned seed = 1;
+    for (int& v: source) {
+        seed = seed * 1664525 + 1013904223;
+        v = static_cast<int>(seed >> 8) - (1 << 23);
+    }
+    std::vector<int> data(source.size());
+    std::vector<int> scratch(source.size());
+
+    std::printf("%dx%d, best of %d runs\n", SIZE, SIZE, RUNS);
+    std::printf("%8s %12s %12s %10s %10s\n", "radius", "box ms", "recursive ms", "box sd", "rec sd");
+    for (const int radius: {1, 2, 5, 10, 20, 50, 100, 200}) {
+        const double boxMs = bestMs(data, source, [&](int* d) {
+            gaussBlur(d, scratch.data(), SIZE, SIZE, radius);
+        });
+        const double recursiveMs = bestMs(data, source, [&](int* d) {
+            gaussBlurRecursive(d, SIZE, SIZE, radius);
+        });
+        const double boxSd = impulseWidth(radius, [&](int* d, const int w, const int h) {
+            gaussBlur(d, w, h, radius);
+        });
+        const double recursiveSd = impulseWidth(radius, [&](int* d, const int w, const int h) {
+            gaussBlurRecursive(d, w, h, radius);
+        });
+        std::printf("%8d %12.2f %12.2f %10.3f %10.3f\n", radius, boxMs, recursiveMs, boxSd, recursiveSd);
+    }
+    return 0;
+}
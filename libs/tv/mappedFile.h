@@ -0,0 +1,196 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TV {
+    /**
+     * File mapped into memory through a movable window. Only the window is mapped at a time,
+     * so files larger than the address space or RAM can be processed piece by piece.
+     */
+    class MappedFile {
+    public:
+        enum class Mode {
+            Read,
+            // creates or truncates the file to the given size
+            Write,
+        };
+
+        MappedFile() = default;
+
+        ~MappedFile() {
+            close();
+        }
+
+        MappedFile(const MappedFile&) = delete;
+
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * Opens the file.
+         *
+         * @param path file path
+         * @param mode access mode
+         * @param size file size in bytes for Mode::Write, ignored for Mode::Read
+         * @return true if the file was opened
+         */
+        bool open(const std::filesystem::path& path, const Mode mode, const uint64_t size = 0) {
+            close();
+            mMode = mode;
+#ifdef _WIN32
+            const bool isWrite = mode == Mode::Write;
+            mFile = CreateFileW(path.c_str(), isWrite ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                FILE_SHARE_READ, nullptr, isWrite ? CREATE_ALWAYS : OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (mFile == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            if (isWrite) {
+                mSize = size;
+            } else {
+                LARGE_INTEGER fileSize;
+                if (!GetFileSizeEx(mFile, &fileSize)) {
+                    close();
+                    return false;
+                }
+                mSize = static_cast<uint64_t>(fileSize.QuadPart);
+            }
+            if (mSize > 0) {
+                mMapping = CreateFileMappingW(mFile, nullptr, isWrite ? PAGE_READWRITE : PAGE_READONLY,
+                                              static_cast<DWORD>(mSize >> 32), static_cast<DWORD>(mSize), nullptr);
+                if (mMapping == nullptr) {
+                    close();
+                    return false;
+                }
+            }
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            mGranularity = info.dwAllocationGranularity;
+#else
+            mFd = mode == Mode::Write
+                      ? ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+                      : ::open(path.c_str(), O_RDONLY);
+            if (mFd < 0) {
+                return false;
+            }
+            if (mode == Mode::Write) {
+                if (ftruncate(mFd, static_cast<off_t>(size)) != 0) {
+                    close();
+                    return false;
+                }
+                mSize = size;
+            } else {
+                struct stat st{};
+                if (fstat(mFd, &st) != 0) {
+                    close();
+                    return false;
+                }
+                mSize = static_cast<uint64_t>(st.st_size);
+            }
+            mGranularity = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+            return true;
+        }
+
+        void close() {
+            unmap();
+#ifdef _WIN32
+            if (mMapping != nullptr) {
+                CloseHandle(mMapping);
+                mMapping = nullptr;
+            }
+            if (mFile != INVALID_HANDLE_VALUE) {
+                CloseHandle(mFile);
+                mFile = INVALID_HANDLE_VALUE;
+            }
+#else
+            if (mFd >= 0) {
+                ::close(mFd);
+                mFd = -1;
+            }
+#endif
+            mSize = 0;
+        }
+
+        /**
+         * Maps bytes [offset...offset + size) of the file, replacing the previous window.
+         * Offset does not have to be aligned.
+         *
+         * @return pointer to the byte at offset, valid until the next map, unmap or close; nullptr on failure
+         */
+        std::byte* map(const uint64_t offset, const uint64_t size) {
+            unmap();
+            if (size == 0 || offset + size > mSize) {
+                return nullptr;
+            }
+            // views have to start at a multiple of the allocation granularity
+            const uint64_t alignedOffset = offset / mGranularity * mGranularity;
+            mViewSize = size + (offset - alignedOffset);
+#ifdef _WIN32
+            mView = MapViewOfFile(mMapping, mMode == Mode::Write ? FILE_MAP_WRITE : FILE_MAP_READ,
+                                  static_cast<DWORD>(alignedOffset >> 32), static_cast<DWORD>(alignedOffset),
+                                  static_cast<SIZE_T>(mViewSize));
+            if (mView == nullptr) {
+                return nullptr;
+            }
+#else
+            void* view = mmap(nullptr, mViewSize, mMode == Mode::Write ? PROT_READ | PROT_WRITE : PROT_READ,
+                              MAP_SHARED, mFd, static_cast<off_t>(alignedOffset));
+            if (view == MAP_FAILED) {
+                return nullptr;
+            }
+            mView = view;
+#endif
+            return static_cast<std::byte*>(mView) + (offset - alignedOffset);
+        }
+
+        void unmap() {
+            if (mView == nullptr) {
+                return;
+            }
+#ifdef _WIN32
+            UnmapViewOfFile(mView);
+#else
+            munmap(mView, mViewSize);
+#endif
+            mView = nullptr;
+        }
+
+        [[nodiscard]] bool isOpen() const {
+#ifdef _WIN32
+            return mFile != INVALID_HANDLE_VALUE;
+#else
+            return mFd >= 0;
+#endif
+        }
+
+        [[nodiscard]] uint64_t getSize() const {
+            return mSize;
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE mFile = INVALID_HANDLE_VALUE;
+        HANDLE mMapping = nullptr;
+#else
+        int mFd = -1;
+#endif
+        Mode mMode = Mode::Read;
+        uint64_t mSize = 0;
+        uint64_t mGranularity = 1;
+        void* mView = nullptr;
+        uint64_t mViewSize = 0;
+    };
+}
@@ -0,0 +1,224 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "threadPool.h"
+#include "tvmath.h"
+
+namespace TV::Math {
+    enum class NoiseType {
+        // interpolated random values at lattice points
+        Value,
+        // interpolated dot products of random lattice gradients (Perlin)
+        Gradient,
+    };
+
+    struct NoiseSettings {
+        NoiseType type = NoiseType::Gradient;
+        uint32_t seed = 0;
+        // lattice cells per sample of the first octave
+        Dec16 frequency = Dec16::from_raw_value(FRACT_16 / 64);
+        // every next octave has double frequency and amplitude multiplied by gain
+        int octaves = 1;
+        Dec gain = DEC_HALF;
+    };
+
+    // Noise internal
+    namespace Internal {
+        inline constexpr uint32_t NOISE_PRIME_X = 0x9e3779b1u;
+        inline constexpr uint32_t NOISE_PRIME_Y = 0x85ebca77u;
+        inline constexpr uint32_t NOISE_PRIME_OCTAVE = 0xc2b2ae3du;
+
+        // lattice hash, xh and yh are cell coordinates multiplied by NOISE_PRIME_X and NOISE_PRIME_Y
+        constexpr uint32_t noiseHash(const uint32_t xh, const uint32_t yh, const uint32_t seed) {
+            uint32_t h = seed ^ xh ^ yh;
+            h ^= h >> 15;
+            h *= 0x2c1b3c6du;
+            h ^= h >> 12;
+            h *= 0x297a2d39u;
+            h ^= h >> 15;
+            return h;
+        }
+
+        // lattice value in [-1...1]
+        constexpr Dec latticeValue(const uint32_t h) {
+            return Dec::from_raw_value(static_cast<int>(boundedRand(h, 2 * FRACT + 1)) - FRACT);
+        }
+
+        // dot product of offset (dx, dy) and one of the diagonal gradients (+-1, +-1), branch free
+        constexpr Dec latticeGradient(const uint32_t h, const Dec dx, const Dec dy) {
+            const int mx = -static_cast<int>(h & 1);
+            const int my = -static_cast<int>((h >> 1) & 1);
+            return Dec::from_raw_value(((dx.raw_value() ^ mx) - mx) + ((dy.raw_value() ^ my) - my));
+        }
+
+        // sample position along one axis split into lattice cell and fraction
+        struct NoiseAxis {
+            uint32_t cellHash;
+            Dec fract;
+            Dec fade;
+        };
+
+        // position of sample p for Q16 step per sample
+        constexpr NoiseAxis noiseAxis(const int p, const int64_t step, const uint32_t prime) {
+            const int64_t pos = p * step;
+            const auto cell = static_cast<uint32_t>(pos >> FRACT_16_BITS);
+            const Dec fract = Dec::from_raw_value(
+                static_cast<int>((pos & (FRACT_16 - 1)) >> (FRACT_16_BITS - FRACT_BITS)));
+            return NoiseAxis{cell * prime, fract, interpQuintic(fract)};
+        }
+
+        // product with the rounding of Dec multiplication but a 32 bit intermediate, which vectorizes unlike
+        // the 64 bit one of Dec. Noise operands are within [-8...8], so the raw product can't overflow
+        constexpr Dec noiseMul(const Dec a, const Dec b) {
+            const int value = a.raw_value() * b.raw_value() / (FRACT / 2);
+            return Dec::from_raw_value(value / 2 + value % 2);
+        }
+
+        constexpr Dec noiseLerp(const Dec a, const Dec b, const Dec t) { return a + noiseMul(t, b - a); }
+
+        // one octave at the given position, in [-1...1]
+        template<NoiseType type>
+        constexpr Dec noiseOctave(const uint32_t seed, const NoiseAxis& x, const NoiseAxis& y) {
+            const uint32_t h00 = noiseHash(x.cellHash, y.cellHash, seed);
+            const uint32_t h10 = noiseHash(x.cellHash + NOISE_PRIME_X, y.cellHash, seed);
+            const uint32_t h01 = noiseHash(x.cellHash, y.cellHash + NOISE_PRIME_Y, seed);
+            const uint32_t h11 = noiseHash(x.cellHash + NOISE_PRIME_X, y.cellHash + NOISE_PRIME_Y, seed);
+            if constexpr (type == NoiseType::Value) {
+                return noiseLerp(noiseLerp(latticeValue(h00), latticeValue(h10), x.fade),
+                                 noiseLerp(latticeValue(h01), latticeValue(h11), x.fade), y.fade);
+            } else {
+                const Dec one{1};
+                return noiseLerp(
+                    noiseLerp(latticeGradient(h00, x.fract, y.fract), latticeGradient(h10, x.fract - one, y.fract),
+                              x.fade),
+                    noiseLerp(latticeGradient(h01, x.fract, y.fract - one),
+                              latticeGradient(h11, x.fract - one, y.fract - one), x.fade), y.fade);
+            }
+        }
+
+        // x positions of a row of samples in structure of arrays layout, so the row loop reads them contiguously
+        struct NoiseAxes {
+            std::vector<uint32_t> cellHash;
+            std::vector<Dec> fract;
+            std::vector<Dec> fade;
+
+            explicit NoiseAxes(const int size) : cellHash(size), fract(size), fade(size) {}
+
+            void set(const int i, const NoiseAxis& axis) {
+                cellHash[i] = axis.cellHash;
+                fract[i] = axis.fract;
+                fade[i] = axis.fade;
+            }
+        };
+
+        // adds amplitude * octave to a row of samples, the type is a template parameter so the loop has no branches
+        template<NoiseType type>
+        void addNoiseRow(const uint32_t seed, const Dec amplitude, const NoiseAxes& x, const NoiseAxis& y,
+                         Dec* row, const int width) {
+            const uint32_t* cellHash = x.cellHash.data();
+            const Dec* fract = x.fract.data();
+            const Dec* fade = x.fade.data();
+            for (int i = 0; i < width; i++) {
+                row[i] += noiseMul(amplitude, noiseOctave<type>(seed, NoiseAxis{cellHash[i], fract[i], fade[i]}, y));
+            }
+        }
+
+        // amplitudes of octaves normalized so their sum is 1
+        inline std::vector<Dec> octaveAmplitudes(const NoiseSettings& settings) {
+            assert(settings.octaves >= 1);
+            std::vector<Dec> amplitudes(settings.octaves);
+            Dec amplitude{1};
+            Dec sum{0};
+            for (Dec& a: amplitudes) {
+                a = amplitude;
+                sum += amplitude;
+                amplitude *= settings.gain;
+            }
+            for (Dec& a: amplitudes) {
+                a /= sum;
+            }
+            return amplitudes;
+        }
+
+        inline int64_t octaveStep(const NoiseSettings& settings, const int octave) {
+            return int64_t{settings.frequency.raw_value()} << octave;
+        }
+
+        constexpr uint32_t octaveSeed(const NoiseSettings& settings, const int octave) {
+            return settings.seed + static_cast<uint32_t>(octave) * NOISE_PRIME_OCTAVE;
+        }
+    }
+
+    /**
+     * Fractal noise at sample (x, y), in about [-1...1]. Uses integer arithmetic only,
+     * so the result is the same on every platform and equals the corresponding fillNoise element.
+     */
+    inline Dec noise(const NoiseSettings& settings, const int x, const int y) {
+        const std::vector<Dec> amplitudes = Internal::octaveAmplitudes(settings);
+        Dec sum{0};
+        for (int o = 0; o < settings.octaves; o++) {
+            const int64_t step = Internal::octaveStep(settings, o);
+            const Internal::NoiseAxis ax = Internal::noiseAxis(x, step, Internal::NOISE_PRIME_X);
+            const Internal::NoiseAxis ay = Internal::noiseAxis(y, step, Internal::NOISE_PRIME_Y);
+            const uint32_t seed = Internal::octaveSeed(settings, o);
+            const Dec value = settings.type == NoiseType::Value
+                                  ? Internal::noiseOctave<NoiseType::Value>(seed, ax, ay)
+                                  : Internal::noiseOctave<NoiseType::Gradient>(seed, ax, ay);
+            sum += Internal::noiseMul(amplitudes[o], value);
+        }
+        return sum;
+    }
+
+    /**
+     * Fills a rectangle of samples [x0...x0 + width) x [y0...y0 + height) with fractal noise.
+     * Samples depend only on their global coordinates, so an area can be filled tile by tile, on any thread,
+     * with the same result. Lattice positions along x are computed once per octave and the row loop
+     * is instantiated per noise type, so it has no branches and only 32 bit arithmetic.
+     *
+     * @param settings noise settings
+     * @param out output array of width * height elements
+     * @param x0 x of the first sample
+     * @param y0 y of the first sample
+     * @param width number of samples in a row
+     * @param height number of rows
+     */
+    inline void fillNoise(const NoiseSettings& settings, Dec* out, const int x0, const int y0,
+                          const int width, const int height) {
+        TV_PROFILE_ZONE("fillNoise");
+        const std::vector<Dec> amplitudes = Internal::octaveAmplitudes(settings);
+        Internal::NoiseAxes axes(width);
+        std::fill_n(out, static_cast<std::size_t>(width) * height, Dec{0});
+        for (int o = 0; o < settings.octaves; o++) {
+            const int64_t step = Internal::octaveStep(settings, o);
+            const uint32_t seed = Internal::octaveSeed(settings, o);
+            const Dec amplitude = amplitudes[o];
+            for (int i = 0; i < width; i++) {
+                axes.set(i, Internal::noiseAxis(x0 + i, step, Internal::NOISE_PRIME_X));
+            }
+            for (int j = 0; j < height; j++) {
+                const Internal::NoiseAxis ay = Internal::noiseAxis(y0 + j, step, Internal::NOISE_PRIME_Y);
+                Dec* row = out + static_cast<std::size_t>(j) * width;
+                if (settings.type == NoiseType::Value) {
+                    Internal::addNoiseRow<NoiseType::Value>(seed, amplitude, axes, ay, row, width);
+                } else {
+                    Internal::addNoiseRow<NoiseType::Gradient>(seed, amplitude, axes, ay, row, width);
+                }
+            }
+        }
+    }
+
+    /**
+     * Fills a rectangle of samples with fractal noise on threads of the given pool, see fillNoise above.
+     * The result is identical to the single threaded version.
+     */
+    inline void fillNoise(ThreadPool& pool, const NoiseSettings& settings, Dec* out, const int x0, const int y0,
+                          const int width, const int height) {
+        // bands of several rows amortize per call setup
+        constexpr int rowGrain = 8;
+        pool.parallelFor(height, rowGrain, [&](const int j0, const int j1) {
+            fillNoise(settings, out + static_cast<std::size_t>(j0) * width, x0, y0 + j0, width, j1 - j0);
+        });
+    }
+}
@@ -0,0 +1,61 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include "threadPool.h"
+#include "tvmath.h"
+
+namespace TV::Math {
+    // Parallel blur internal
+    namespace Internal {
+        /**
+         * Parallel version of boxBlur. Horizontal pass is split by row bands, vertical pass by column bands
+         * of whole strips, so every output element is computed by the same code as in the serial version
+         * and the result is bit identical. Passes are separated by the barrier at the end of parallelFor.
+         */
+        template<int Channels = 1, typename T>
+        void boxBlur(ThreadPool& pool, T* data, T* scratch, const int w, const int h, const int r) {
+            pool.parallelFor(h, 1, [=](const int y0, const int y1) {
+                boxBlurH<Channels>(data, scratch, w, r, y0, y1);
+            });
+            pool.parallelFor(w * Channels, BLUR_STRIP, [=](const int x0, const int x1) {
+                boxBlurT(scratch, data, w * Channels, h, r, x0, x1);
+            });
+        }
+    }
+
+    /**
+     * Performs Gaussian blur on the given data array on threads of the given pool.
+     * Result is bit identical to the single threaded version.
+     *
+     * @param pool thread pool running the passes
+     * @param input input array of 2D data, receives the result
+     * @param scratch buffer of at least xSize * ySize elements
+     * @param xSize data width
+     * @param ySize data height
+     * @param k1 radius for 1st kernel box
+     * @param k2 radius for 2nd kernel box
+     * @param k3 radius for 3rd kernel box
+     */
+    inline void gaussBlur(ThreadPool& pool, int* input, int* scratch, const int xSize, const int ySize,
+                          const int k1, const int k2, const int k3) {
+        TV_PROFILE_ZONE("gaussBlur");
+        Internal::boxBlur(pool, input, scratch, xSize, ySize, k1);
+        Internal::boxBlur(pool, input, scratch, xSize, ySize, k2);
+        Internal::boxBlur(pool, input, scratch, xSize, ySize, k3);
+    }
+
+    /**
+     * Performs Gaussian blur on the given data array for given kernel radius on threads of the given pool.
+     *
+     * @param pool thread pool running the passes
+     * @param input input array of 2D data, receives the result
+     * @param scratch buffer of at least xSize * ySize elements
+     * @param xSize data width
+     * @param ySize data height
+     * @param radius kernel radius
+     */
+    inline void gaussBlur(ThreadPool& pool, int* input, int* scratch, const int xSize, const int ySize,
+                          const int radius) {
+        const auto [k1, k2, k3] = gaussBoxRadii(radius);
+        gaussBlur(pool, input, scratch, xSize, ySize, k1, k2, k3);
+    }
+}
@@ -0,0 +1,185 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped timing zones. Zones are compiled in only when TV_PROFILE is defined,
+// otherwise TV_PROFILE_ZONE expands to nothing and costs nothing.
+#ifdef TV_PROFILE
+#define TV_PROFILE_CONCAT_IMPL(a, b) a##b
+#define TV_PROFILE_CONCAT(a, b) TV_PROFILE_CONCAT_IMPL(a, b)
+#define TV_PROFILE_ZONE(name) const TV::ProfileZone TV_PROFILE_CONCAT(tvProfileZone, __LINE__)(name)
+#else
+#define TV_PROFILE_ZONE(name)
+#endif
+
+namespace TV {
+    /**
+     * Collects timings of named zones. Time spent in a zone is summed over a frame and stored
+     * in a rolling history of the last HISTORY_SIZE frames. Optionally every zone is also recorded
+     * as a separate event, which can be dumped to Chrome trace JSON (chrome://tracing, Perfetto).
+     *
+     * Zone names are expected to be string literals: zones are identified by pointer.
+     */
+    class Profiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr int HISTORY_SIZE = 240;
+        // upper bound for the recorded trace to not eat all the memory in long sessions
+        static constexpr std::size_t MAX_TRACE_EVENTS = 4'000'000;
+
+        struct ZoneHistory {
+            const char* name;
+            // milliseconds per frame, ring buffer with the head at Profiler::getHistoryOffset()
+            std::array<float, HISTORY_SIZE> ms{};
+            float frameMs = 0.f;
+        };
+
+        struct TraceEvent {
+            const char* name;
+            int64_t startUs;
+            int64_t durationUs;
+            int threadIdx;
+        };
+
+        static Profiler& instance() {
+            static Profiler profiler;
+            return profiler;
+        }
+
+        // pushes time accumulated in the current frame to the history
+        void endFrame() {
+            std::lock_guard lock(mMutex);
+            for (ZoneHistory& zone: mZones) {
+                zone.ms[mHistoryOffset] = zone.frameMs;
+                zone.frameMs = 0.f;
+            }
+            mHistoryOffset = (mHistoryOffset + 1) % HISTORY_SIZE;
+        }
+
+        void record(const char* name, const Clock::time_point start, const Clock::time_point end) {
+            const auto durationUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            const float ms = std::chrono::duration<float, std::milli>(end - start).count();
+
+            std::lock_guard lock(mMutex);
+            findOrAddZone(name).frameMs += ms;
+            if (mIsTraceCapturing && mTraceEvents.size() < MAX_TRACE_EVENTS) {
+                const auto startUs = std::chrono::duration_cast<std::chrono::microseconds>(start - mEpoch).count();
+                mTraceEvents.push_back(TraceEvent{name, startUs, durationUs, threadIdx()});
+            }
+        }
+
+        // copy of the zone histories, safe to use while other threads record zones
+        [[nodiscard]] std::vector<ZoneHistory> getZones() const {
+            std::lock_guard lock(mMutex);
+            return mZones;
+        }
+
+        // index of the oldest history entry
+        [[nodiscard]] int getHistoryOffset() const {
+            std::lock_guard lock(mMutex);
+            return mHistoryOffset;
+        }
+
+        void setTraceCapturing(const bool isCapturing) {
+            std::lock_guard lock(mMutex);
+            mIsTraceCapturing = isCapturing;
+        }
+
+        [[nodiscard]] bool isTraceCapturing() const {
+            std::lock_guard lock(mMutex);
+            return mIsTraceCapturing;
+        }
+
+        [[nodiscard]] std::size_t getTraceEventCount() const {
+            std::lock_guard lock(mMutex);
+            return mTraceEvents.size();
+        }
+
+        void clearTrace() {
+            std::lock_guard lock(mMutex);
+            mTraceEvents.clear();
+        }
+
+        /**
+         * Writes recorded events in Chrome trace event format.
+         *
+         * @param path output file path
+         * @return true if the file was written
+         */
+        bool writeChromeTrace(const std::string& path) const {
+            std::ofstream out(path, std::ios::binary);
+            if (!out) {
+                return false;
+            }
+
+            std::lock_guard lock(mMutex);
+            out << "{\"traceEvents\":[";
+            for (std::size_t i = 0; i < mTraceEvents.size(); i++) {
+                const TraceEvent& e = mTraceEvents[i];
+                if (i > 0) {
+                    out << ',';
+                }
+                out << "\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.threadIdx
+                        << ",\"ts\":" << e.startUs << ",\"dur\":" << e.durationUs << '}';
+            }
+            out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+            return static_cast<bool>(out);
+        }
+
+    private:
+        mutable std::mutex mMutex;
+        std::vector<ZoneHistory> mZones;
+        int mHistoryOffset = 0;
+        bool mIsTraceCapturing = false;
+        std::vector<TraceEvent> mTraceEvents;
+        const Clock::time_point mEpoch = Clock::now();
+
+        Profiler() = default;
+
+        // zone count is small, linear search is faster than any map here
+        ZoneHistory& findOrAddZone(const char* name) {
+            for (ZoneHistory& zone: mZones) {
+                if (zone.name == name) {
+                    return zone;
+                }
+            }
+            mZones.push_back(ZoneHistory{name});
+            return mZones.back();
+        }
+
+        // small sequential thread ids look better in trace viewers than native ones
+        static int threadIdx() {
+            static std::atomic<int> nextIdx{0};
+            thread_local const int idx = nextIdx++;
+            return idx;
+        }
+    };
+
+    // Measures time between construction and destruction and reports it to the profiler
+    class ProfileZone {
+    public:
+        explicit ProfileZone(const char* name)
+            : mName(name),
+              mStart(Profiler::Clock::now()) {
+        }
+
+        ~ProfileZone() {
+            Profiler::instance().record(mName, mStart, Profiler::Clock::now());
+        }
+
+        ProfileZone(const ProfileZone&) = delete;
+
+        ProfileZone& operator=(const ProfileZone&) = delete;
+
+    private:
+        const char* mName;
+        const Profiler::Clock::time_point mStart;
+    };
+}
@@ -0,0 +1,165 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "tvmath.h"
+
+namespace TV::Math {
+    /**
+     * Counter-based random generator Philox4x32-10 (Salmon et al.: Parallel random numbers: as easy as 1, 2, 3, 2011).
+     * Every block of four numbers is a pure function of (seed, stream, block index), so any part of a sequence
+     * can be generated independently: a parallel job gives each tile its own stream or seeks to the tile's
+     * position and gets the same numbers with any number of threads. Platform independent.
+     */
+    class Philox {
+    public:
+        using Counter = std::array<uint32_t, 4>;
+        using Key = std::array<uint32_t, 2>;
+
+        // blocks generated together by bulk fill: their rounds are independent, so the multiplications
+        // of different blocks overlap in the pipeline, about twice the speed of operator() calls.
+        // The widening multiply doesn't vectorize profitably on AVX2: packing the 64 bit products back
+        // costs as much as it saves, so the lanes are left to the scalar multipliers.
+        static constexpr int BATCH = 16;
+
+        explicit Philox(const uint64_t seed, const uint64_t stream = 0)
+            : mKey{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+              mStream(stream) {
+        }
+
+        // the Philox4x32-10 bijection
+        static constexpr Counter block(Counter ctr, Key key) {
+            for (int round = 0; round < 10; round++) {
+                if (round > 0) {
+                    key[0] += W0;
+                    key[1] += W1;
+                }
+                const uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+                const uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+                ctr = Counter{
+                    static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+                    static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0)
+                };
+            }
+            return ctr;
+        }
+
+        // next number of the sequence
+        uint32_t operator()() {
+            if (mBufferPos == 4) {
+                mBuffer = block(counter(mBlock++), mKey);
+                mBufferPos = 0;
+            }
+            return mBuffer[mBufferPos++];
+        }
+
+        // moves to the given position of the sequence, in numbers from the start of the stream
+        void seek(const uint64_t position) {
+            mBlock = position / 4;
+            mBufferPos = 4;
+            const auto skip = static_cast<int>(position % 4);
+            for (int i = 0; i < skip; i++) {
+                (*this)();
+            }
+        }
+
+        // fills out with next numbers of the sequence, same numbers as calling operator() out.size() times
+        void fill(const std::span<uint32_t> out) {
+            std::size_t i = 0;
+            while (i < out.size() && mBufferPos < 4) {
+                out[i++] = mBuffer[mBufferPos++];
+            }
+            const std::size_t blocks = (out.size() - i) / 4;
+            std::size_t b = 0;
+            for (; b + BATCH <= blocks; b += BATCH) {
+                fillBatch(out.data() + i + b * 4);
+            }
+            for (; b < blocks; b++) {
+                const Counter r = block(counter(mBlock++), mKey);
+                std::copy(r.begin(), r.end(), out.begin() + static_cast<std::ptrdiff_t>(i + b * 4));
+            }
+            for (i += blocks * 4; i < out.size(); i++) {
+                out[i] = (*this)();
+            }
+        }
+
+        // Fills out with uniform numbers in [0...range) without bias, see boundedRandUnbiased.
+        // Numbers rejected by it are replaced by numbers after the filled span, so unlike fill the result
+        // differs from sequential boundedRandUnbiased(operator()(), ...) calls once a rejection happens.
+        void fillBounded(const std::span<uint32_t> out, const uint32_t range) {
+            fill(out);
+            for (uint32_t& v: out) {
+                v = boundedRandUnbiased(v, *this, range);
+            }
+        }
+
+        // fills out with uniform numbers in [0...1)
+        void fillDec(const std::span<Dec> out) {
+            std::array<uint32_t, BATCH * 4> raw;
+            for (std::size_t i = 0; i < out.size(); i += raw.size()) {
+                const std::size_t n = std::min(raw.size(), out.size() - i);
+                fill(std::span(raw.data(), n));
+                for (std::size_t j = 0; j < n; j++) {
+                    out[i + j] = Dec::from_raw_value(static_cast<int>(raw[j] >> (32 - FRACT_BITS)));
+                }
+            }
+        }
+
+    private:
+        static constexpr uint32_t M0 = 0xD2511F53u;
+        static constexpr uint32_t M1 = 0xCD9E8D57u;
+        static constexpr uint32_t W0 = 0x9E3779B9u;
+        static constexpr uint32_t W1 = 0xBB67AE85u;
+
+        Key mKey;
+        uint64_t mStream;
+        // index of the next block to generate
+        uint64_t mBlock = 0;
+        Counter mBuffer{};
+        int mBufferPos = 4;
+
+        [[nodiscard]] Counter counter(const uint64_t blockIdx) const {
+            return Counter{
+                static_cast<uint32_t>(blockIdx), static_cast<uint32_t>(blockIdx >> 32),
+                static_cast<uint32_t>(mStream), static_cast<uint32_t>(mStream >> 32)
+            };
+        }
+
+        // BATCH blocks in structure of arrays layout, each round is a loop over independent lanes
+        void fillBatch(uint32_t* out) {
+            uint32_t c0[BATCH], c1[BATCH], c2[BATCH], c3[BATCH];
+            for (int l = 0; l < BATCH; l++) {
+                const uint64_t blockIdx = mBlock + l;
+                c0[l] = static_cast<uint32_t>(blockIdx);
+                c1[l] = static_cast<uint32_t>(blockIdx >> 32);
+                c2[l] = static_cast<uint32_t>(mStream);
+                c3[l] = static_cast<uint32_t>(mStream >> 32);
+            }
+            mBlock += BATCH;
+
+            Key key = mKey;
+            for (int round = 0; round < 10; round++) {
+                if (round > 0) {
+                    key[0] += W0;
+                    key[1] += W1;
+                }
+                for (int l = 0; l < BATCH; l++) {
+                    const uint64_t p0 = static_cast<uint64_t>(M0) * c0[l];
+                    const uint64_t p1 = static_cast<uint64_t>(M1) * c2[l];
+                    c0[l] = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ key[0];
+                    c2[l] = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ key[1];
+                    c1[l] = static_cast<uint32_t>(p1);
+                    c3[l] = static_cast<uint32_t>(p0);
+                }
+            }
+            for (int l = 0; l < BATCH; l++) {
+                out[l * 4] = c0[l];
+                out[l * 4 + 1] = c1[l];
+                out[l * 4 + 2] = c2[l];
+                out[l * 4 + 3] = c3[l];
+            }
+        }
+    };
+}
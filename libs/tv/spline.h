@@ -3,6 +3,7 @@
 #include <vector>
 #include <algorithm>
 #include "tvmath.h"
+#include "profiler.h"
 
 namespace TV::Math {
     // 16-16 scheme is imprecise, since it can easily overflow integral part
@@ -16,6 +17,9 @@ namespace TV::Math {
         // returns [x,y] for given coord value
         [[nodiscard]] virtual std::pair<Dec16, Dec16> value(Dec16 coord) const = 0;
 
+        // returns [dx,dy] tangent direction for given coord value. Length is not normalized
+        [[nodiscard]] virtual std::pair<Dec16, Dec16> tangent(Dec16 coord) const = 0;
+
         [[nodiscard]] virtual Dec16 getCoordMin() const = 0;
 
         [[nodiscard]] virtual Dec16 getCoordMax() const = 0;
@@ -38,7 +42,8 @@ namespace TV::Math {
               mOrigXMin(origXMin),
               mOrigXMax(origXMax),
               mOrigYMin(origYMin),
-              mOrigYMax(origYMax) {
+              mOrigYMax(origYMax),
+              mKnotSearch(this->knots) {
         }
 
         [[nodiscard]] std::pair<Dec16, Dec16> value(const Dec16 coord) const override {
@@ -50,7 +55,7 @@ namespace TV::Math {
             assert(xNorm >= knots[0]);
             assert(xNorm <= knots[segmentNum]);
 
-            int i = binSearch(knots, xNorm);
+            int i = mKnotSearch.lowerBound(xNorm);
             assert(i >= 0);
             if (i > 0) {
                 --i;
@@ -61,6 +66,54 @@ namespace TV::Math {
             return rescale(r, Dec16{0}, mYScale, resMin, resMax);
         }
 
+        /**
+         * Batch version of value: out[i] = value(coords[i]).second. Coordinates outside of the function
+         * domain are clamped to it. Consecutive coordinates in the same segment skip the knot search,
+         * so spatially coherent data (heightmaps, signals) is cheap.
+         *
+         * @param coords input coordinates
+         * @param out output values, may be the same array as coords
+         * @param count number of elements
+         */
+        void values(const Dec16* coords, Dec16* out, const std::size_t count) const {
+            int i = 0;
+            for (std::size_t j = 0; j < count; j++) {
+                const Dec16 coord = clamp(coords[j], mOrigXMin, mOrigXMax);
+                const Dec16 xNorm = clamp(rescale(coord, mOrigXMin, mOrigXMax, Dec16{0}, mXScale),
+                                          knots[0], knots[segmentNum]);
+                // segment i covers (knots[i]...knots[i + 1]], the first one also knots[0], same as valueNorm picks
+                if (xNorm > knots[i + 1] || (xNorm <= knots[i] && i > 0)) {
+                    i = std::max(0, mKnotSearch.lowerBound(xNorm) - 1);
+                }
+                const Dec16 r = interpPolynomial(polynomials[i], xNorm - knots[i]);
+                out[j] = rescale(r, Dec16{0}, mYScale, mOrigYMin, mOrigYMax);
+            }
+        }
+
+        [[nodiscard]] std::pair<Dec16, Dec16> tangent(const Dec16 coord) const override {
+            const Dec16 xNorm = rescale(coord, mOrigXMin, mOrigXMax, Dec16{0}, mXScale);
+            // derivative by normalized x converted to original units
+            return std::pair{
+                (mOrigXMax - mOrigXMin) / mXScale,
+                derivativeNorm(xNorm, mOrigYMin, mOrigYMax)
+            };
+        }
+
+        // Derivative by normalized x of the value rescaled to [resMin...resMax]
+        [[nodiscard]] Dec16 derivativeNorm(const Dec16 xNorm, const Dec16 resMin, const Dec16 resMax) const {
+            assert(xNorm >= knots[0]);
+            assert(xNorm <= knots[segmentNum]);
+
+            int i = mKnotSearch.lowerBound(xNorm);
+            assert(i >= 0);
+            if (i > 0) {
+                --i;
+            }
+
+            const Dec16 r = interpPolynomialDerivative(polynomials[i], xNorm - knots[i]);
+            return r * ((resMax - resMin) / mYScale);
+        }
+
         [[nodiscard]] Dec16 getCoordMin() const override {
             return mOrigXMin;
         }
@@ -71,7 +124,49 @@ namespace TV::Math {
 
         [[nodiscard]] int getClosestKnotIndex(const Dec16 coord) const override {
             const Dec16 coordNorm = rescale(coord, mOrigXMin, mOrigXMax, Dec16{0}, mXScale);
-            return binSearch(knots, coordNorm);
+            return mKnotSearch.lowerBound(coordNorm);
+        }
+
+        [[nodiscard]] const std::vector<Dec16>& getKnots() const {
+            return knots;
+        }
+
+        [[nodiscard]] const std::vector<std::vector<Dec16>>& getPolynomials() const {
+            return polynomials;
+        }
+
+        [[nodiscard]] Dec16 getXScale() const {
+            return mXScale;
+        }
+
+        [[nodiscard]] Dec16 getYScale() const {
+            return mYScale;
+        }
+
+        [[nodiscard]] Dec16 getOrigYMin() const {
+            return mOrigYMin;
+        }
+
+        [[nodiscard]] Dec16 getOrigYMax() const {
+            return mOrigYMax;
+        }
+
+        // Horner's scheme for polynomial evaluation
+        [[nodiscard]] static Dec16 interpPolynomial(const Dec16* coefficients, const int n, const Dec16 t) {
+            Dec16 result = coefficients[n - 1];
+            for (int j = n - 2; j >= 0; j--) {
+                result = t * result + coefficients[j];
+            }
+            return result;
+        }
+
+        // Horner's scheme for the first derivative of polynomial
+        [[nodiscard]] static Dec16 interpPolynomialDerivative(const Dec16* coefficients, const int n, const Dec16 t) {
+            Dec16 result = (n - 1) * coefficients[n - 1];
+            for (int j = n - 2; j >= 1; j--) {
+                result = t * result + j * coefficients[j];
+            }
+            return result;
         }
 
     private:
@@ -98,14 +193,15 @@ namespace TV::Math {
         const Dec16 mOrigYMin;
         const Dec16 mOrigYMax;
 
-        // Horner's scheme for polynomial evaluation
+        // knots in search friendly layout
+        const EytzingerSearch<Dec16> mKnotSearch;
+
         [[nodiscard]] static Dec16 interpPolynomial(const std::vector<Dec16>& coefficients, const Dec16 t) {
-            const int n = coefficients.size();
-            Dec16 result = coefficients[n - 1];
-            for (int j = n - 2; j >= 0; j--) {
-                result = t * result + coefficients[j];
-            }
-            return result;
+            return interpPolynomial(coefficients.data(), static_cast<int>(coefficients.size()), t);
+        }
+
+        [[nodiscard]] static Dec16 interpPolynomialDerivative(const std::vector<Dec16>& coefficients, const Dec16 t) {
+            return interpPolynomialDerivative(coefficients.data(), static_cast<int>(coefficients.size()), t);
         }
     };
 
@@ -122,7 +218,8 @@ namespace TV::Math {
               mXMin(xMin),
               mXMax(xMax),
               mYMin(yMin),
-              mYMax(yMax) {
+              mYMax(yMax),
+              mTKnotSearch(mTKnots) {
         }
 
         [[nodiscard]] std::pair<Dec16, Dec16> value(const Dec16 coord) const override {
@@ -137,6 +234,10 @@ namespace TV::Math {
             return mYFunc.valueNorm(t, mYMin, mYMax);
         }
 
+        [[nodiscard]] std::pair<Dec16, Dec16> tangent(const Dec16 coord) const override {
+            return std::pair{mXFunc.derivativeNorm(coord, mXMin, mXMax), mYFunc.derivativeNorm(coord, mYMin, mYMax)};
+        }
+
         [[nodiscard]] Dec16 getCoordMin() const override {
             return mTKnots[0];
         }
@@ -146,7 +247,35 @@ namespace TV::Math {
         }
 
         [[nodiscard]] int getClosestKnotIndex(const Dec16 coord) const override {
-            return binSearch(mTKnots, coord);
+            return mTKnotSearch.lowerBound(coord);
+        }
+
+        [[nodiscard]] const PolynomialSplineFunction& getXFunc() const {
+            return mXFunc;
+        }
+
+        [[nodiscard]] const PolynomialSplineFunction& getYFunc() const {
+            return mYFunc;
+        }
+
+        [[nodiscard]] const std::vector<Dec16>& getTKnots() const {
+            return mTKnots;
+        }
+
+        [[nodiscard]] Dec16 getXMin() const {
+            return mXMin;
+        }
+
+        [[nodiscard]] Dec16 getXMax() const {
+            return mXMax;
+        }
+
+        [[nodiscard]] Dec16 getYMin() const {
+            return mYMin;
+        }
+
+        [[nodiscard]] Dec16 getYMax() const {
+            return mYMax;
         }
 
     private:
@@ -157,6 +286,7 @@ namespace TV::Math {
         const Dec16 mXMax;
         const Dec16 mYMin;
         const Dec16 mYMax;
+        const EytzingerSearch<Dec16> mTKnotSearch;
     };
 
     // Interpolator is a class that generates interpolator functions,
@@ -187,18 +317,22 @@ namespace TV::Math {
         }
 
         [[nodiscard]] PolynomialSplineFunction interpolateLinear() const {
+            TV_PROFILE_ZONE("Interpolator::interpolateLinear");
             return interpolateLinear(mXNormVals, mYNormVals);
         }
 
         [[nodiscard]] PolynomialSplineFunction interpolateNatural() const {
+            TV_PROFILE_ZONE("Interpolator::interpolateNatural");
             return interpolateNatural(mXNormVals, mYNormVals);
         }
 
         [[nodiscard]] PolynomialSplineFunction interpolateAkima() const {
+            TV_PROFILE_ZONE("Interpolator::interpolateAkima");
             return interpolateAkima(mXNormVals, mYNormVals);
         }
 
         [[nodiscard]] Parametric2DPolynomialSplineFunction interpolate2D() const {
+            TV_PROFILE_ZONE("Interpolator::interpolate2D");
             return interpolate2D(mXNormVals, mYNormVals);
         }
 
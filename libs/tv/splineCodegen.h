@@ -0,0 +1,247 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "spline.h"
+
+namespace TV::Math {
+    // segment searches up to this size are emitted as nested ifs, larger ones as a fixed step loop
+    inline constexpr int CODEGEN_MAX_UNROLLED_SEGMENTS = 64;
+
+    // Code generator internal
+    namespace Internal {
+        // fpm::fixed multiplication and division of Dec16 raw values with the same rounding
+        inline constexpr std::string_view CODEGEN_ARITHMETIC = R"(    namespace Internal {
+        inline constexpr int64_t FRACTION_MULT = int64_t{1} << 16;
+
+        constexpr int32_t mul(const int32_t a, const int32_t b) {
+            const int64_t v = static_cast<int64_t>(a) * b / (FRACTION_MULT / 2);
+            return static_cast<int32_t>(v / 2 + v % 2);
+        }
+
+        constexpr int32_t div(const int32_t a, const int32_t b) {
+            const int64_t v = static_cast<int64_t>(a) * FRACTION_MULT * 2 / b;
+            return static_cast<int32_t>(v / 2 + v % 2);
+        }
+
+        constexpr int32_t clamp(const int32_t v, const int32_t lo, const int32_t hi) {
+            return v < lo ? lo : v > hi ? hi : v;
+        }
+    }
+)";
+
+        // int32 literal, the minimum can't be written as a negated literal
+        inline std::string codegenLiteral(const Dec16 value) {
+            const int32_t raw = value.raw_value();
+            if (raw == std::numeric_limits<int32_t>::min()) {
+                return "(-2147483647 - 1)";
+            }
+            return std::to_string(raw);
+        }
+
+        inline void emitConstant(std::ostream& out, const std::string& name, const Dec16 value) {
+            out << "    inline constexpr int32_t " << name << " = " << codegenLiteral(value) << ";\n";
+        }
+
+        // nested ifs selecting segment i of [lo...hi] with knots[i] < x <= knots[i + 1]
+        inline void emitSearchNode(std::ostream& out, const std::string& knots, const int lo, const int hi,
+                                   const int depth) {
+            const std::string indent(4 * depth, ' ');
+            if (lo == hi) {
+                out << indent << "return " << lo << ";\n";
+                return;
+            }
+            const int mid = (lo + hi + 1) / 2;
+            out << indent << "if (x <= " << knots << "[" << mid << "]) {\n";
+            emitSearchNode(out, knots, lo, mid - 1, depth + 1);
+            out << indent << "}\n";
+            emitSearchNode(out, knots, mid, hi, depth);
+        }
+
+        // the same segment PolynomialSplineFunction::valueNorm picks: the first one for x <= knots[0]
+        inline void emitSegmentSearch(std::ostream& out, const std::string& suffix, const std::string& prefix,
+                                      const int segments) {
+            const std::string knots = prefix + "KNOTS";
+            // a single segment needs no search and x stays unnamed to keep the header warning free
+            out << "    constexpr int segment" << suffix << (segments > 1 ? "(const int32_t x) {\n" : "(int32_t) {\n");
+            if (segments <= CODEGEN_MAX_UNROLLED_SEGMENTS) {
+                emitSearchNode(out, knots, 0, segments - 1, 2);
+            } else {
+                // number of inner knots less than x, the loop has a constant trip count and no data dependent jumps
+                int step = 1;
+                while (step * 2 < segments) {
+                    step *= 2;
+                }
+                out << "        int i = 0;\n"
+                        << "        for (int step = " << step << "; step > 0; step >>= 1) {\n"
+                        << "            i += i + step < " << segments << " && " << knots
+                        << "[i + step] < x ? step : 0;\n"
+                        << "        }\n"
+                        << "        return i;\n";
+            }
+            out << "    }\n\n";
+        }
+
+        // knot and coefficient arrays, segment search and unrolled Horner scheme of one polynomial function
+        inline void emitPolynomial(std::ostream& out, const PolynomialSplineFunction& func,
+                                   const std::string& suffix, const std::string& prefix) {
+            const std::vector<Dec16>& knots = func.getKnots();
+            const std::vector<std::vector<Dec16>>& polynomials = func.getPolynomials();
+            const int segments = static_cast<int>(polynomials.size());
+            assert(segments > 0);
+            int coefficients = 1;
+            for (const std::vector<Dec16>& p: polynomials) {
+                coefficients = std::max(coefficients, static_cast<int>(p.size()));
+            }
+
+            out << "    inline constexpr int " << prefix << "SEGMENTS = " << segments << ";\n";
+            out << "    inline constexpr int32_t " << prefix << "KNOTS[" << segments + 1 << "] = {";
+            for (int i = 0; i <= segments; i++) {
+                out << (i % 8 == 0 ? "\n        " : " ") << codegenLiteral(knots[i]) << ",";
+            }
+            out << "\n    };\n";
+            // lower degree polynomials are padded with leading zeros, Horner steps over them are exact
+            out << "    inline constexpr int32_t " << prefix << "POLYNOMIALS[" << segments << "][" << coefficients
+                    << "] = {\n";
+            for (const std::vector<Dec16>& p: polynomials) {
+                out << "        {";
+                for (int j = 0; j < coefficients; j++) {
+                    out << (j > 0 ? ", " : "") << (j < static_cast<int>(p.size()) ? codegenLiteral(p[j]) : "0");
+                }
+                out << "},\n";
+            }
+            out << "    };\n\n";
+
+            emitSegmentSearch(out, suffix, prefix, segments);
+
+            out << "    constexpr int32_t polynomial" << suffix << "(const int i, const int32_t t) {\n"
+                    << "        const int32_t* c = " << prefix << "POLYNOMIALS[i];\n"
+                    << "        int32_t r = c[" << coefficients - 1 << "];\n";
+            for (int j = coefficients - 2; j >= 0; j--) {
+                out << "        r = Internal::mul(t, r) + c[" << j << "];\n";
+            }
+            out << "        return r;\n"
+                    << "    }\n\n";
+        }
+
+        // statement returning rescale(r, 0, yScale, resMin, resMax) in the same order of operations
+        inline void emitValueRescale(std::ostream& out, const std::string& prefix, const Dec16 yScale,
+                                     const Dec16 resMin, const Dec16 resMax) {
+            const Dec16 range = resMax - resMin;
+            if (yScale > resMax) {
+                out << "        return " << prefix << "MIN + Internal::mul(Internal::div(r, " << codegenLiteral(yScale)
+                        << "), " << codegenLiteral(range) << ");\n";
+            } else {
+                out << "        return " << prefix << "MIN + Internal::mul(" << codegenLiteral(range / yScale)
+                        << ", r);\n";
+            }
+        }
+
+        inline void emitHeaderStart(std::ostream& out, const std::string_view kind, const std::string_view name) {
+            assert(!name.empty());
+            out << "// Generated from " << kind << ", do not edit.\n"
+                    << "// All values are Dec16 (Q16.16) raw values, results are bit-exact with the source function.\n"
+                    << "#pragma once\n"
+                    << "#include <cstdint>\n\n"
+                    << "namespace " << name << " {\n"
+                    << CODEGEN_ARITHMETIC << "\n";
+        }
+    }
+
+    /**
+     * Writes a self-contained C++ header that evaluates the given function without the library:
+     * constexpr knots and coefficients, an unrolled search tree over knots and fixed-degree Horner scheme.
+     * The header defines in namespace name: constexpr int32_t value(int32_t x) that equals
+     * func.value(x).second for x in the domain; x outside of it is clamped like values() does.
+     *
+     * @param out output stream
+     * @param func function to bake
+     * @param name namespace of the generated code, has to be a valid identifier
+     */
+    inline void writeSplineHeader(std::ostream& out, const PolynomialSplineFunction& func, const std::string_view name) {
+        using namespace Internal;
+        emitHeaderStart(out, "PolynomialSplineFunction", name);
+
+        const Dec16 xMin = func.getCoordMin();
+        const Dec16 xMax = func.getCoordMax();
+        const Dec16 xScale = func.getXScale();
+        emitConstant(out, "X_MIN", xMin);
+        emitConstant(out, "X_MAX", xMax);
+        emitConstant(out, "Y_MIN", func.getOrigYMin());
+        out << "\n";
+        emitPolynomial(out, func, "", "");
+
+        out << "    constexpr int32_t value(const int32_t x) {\n"
+                << "        const int32_t xClamped = Internal::clamp(x, X_MIN, X_MAX);\n";
+        // rescale(x, xMin, xMax, 0, xScale) with the branch resolved for these bounds
+        if (xMax > xScale) {
+            out << "        const int32_t xScaled = Internal::mul(Internal::div(xClamped - X_MIN, "
+                    << codegenLiteral(xMax - xMin) << "), " << codegenLiteral(xScale) << ");\n";
+        } else {
+            out << "        const int32_t xScaled = Internal::mul(" << codegenLiteral(xScale / (xMax - xMin))
+                    << ", xClamped - X_MIN);\n";
+        }
+        out << "        const int32_t xNorm = Internal::clamp(xScaled, KNOTS[0], KNOTS[SEGMENTS]);\n"
+                << "        const int i = segment(xNorm);\n"
+                << "        const int32_t r = polynomial(i, xNorm - KNOTS[i]);\n";
+        emitValueRescale(out, "Y_", func.getYScale(), func.getOrigYMin(), func.getOrigYMax());
+        out << "    }\n"
+                << "}\n";
+    }
+
+    /**
+     * Writes a self-contained C++ header for the parametric function, see writeSplineHeader above.
+     * The header defines valueX(t) and valueY(t) that equal func.value(t) for t in the domain.
+     */
+    inline void writeSplineHeader(std::ostream& out, const Parametric2DPolynomialSplineFunction& func,
+                                  const std::string_view name) {
+        using namespace Internal;
+        emitHeaderStart(out, "Parametric2DPolynomialSplineFunction", name);
+
+        emitConstant(out, "X_MIN", func.getXMin());
+        emitConstant(out, "Y_MIN", func.getYMin());
+        out << "\n";
+        const std::pair<const PolynomialSplineFunction&, Dec16> axes[] = {
+            {func.getXFunc(), func.getXMax()},
+            {func.getYFunc(), func.getYMax()},
+        };
+        for (int axis = 0; axis < 2; axis++) {
+            const std::string suffix = axis == 0 ? "X" : "Y";
+            const std::string prefix = suffix + "_";
+            const PolynomialSplineFunction& axisFunc = axes[axis].first;
+            emitPolynomial(out, axisFunc, suffix, prefix);
+
+            out << "    constexpr int32_t value" << suffix << "(const int32_t t) {\n"
+                    << "        const int32_t tNorm = Internal::clamp(t, " << prefix << "KNOTS[0], "
+                    << prefix << "KNOTS[" << prefix << "SEGMENTS]);\n"
+                    << "        const int i = segment" << suffix << "(tNorm);\n"
+                    << "        const int32_t r = polynomial" << suffix << "(i, tNorm - " << prefix << "KNOTS[i]);\n";
+            const Dec16 resMin = axis == 0 ? func.getXMin() : func.getYMin();
+            emitValueRescale(out, prefix, axisFunc.getYScale(), resMin, axes[axis].second);
+            out << "    }\n"
+                    << (axis == 0 ? "\n" : "");
+        }
+        out << "}\n";
+    }
+
+    /**
+     * Writes the generated header of the function to a file, see writeSplineHeader above.
+     *
+     * @return true if the file was written
+     */
+    template<typename Function>
+    bool writeSplineHeader(const std::filesystem::path& path, const Function& func, const std::string_view name) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            return false;
+        }
+        writeSplineHeader(out, func, name);
+        return static_cast<bool>(out);
+    }
+}
@@ -0,0 +1,338 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "spline.h"
+
+namespace TV::Math {
+    // smallest smoothing used by SplineFitter::fit (about 0.001), keeps segments without samples solvable
+    // and the system well enough conditioned for fixed point; negligible where samples are present
+    inline constexpr Dec16 FIT_MIN_SMOOTHING = Dec16::from_raw_value(64);
+
+    // Spline fitter internal
+    namespace Internal {
+        // basis weights fixed point bits
+        inline constexpr int FIT_WEIGHT_BITS = 15;
+        // normalized sample values fixed point bits
+        inline constexpr int FIT_VALUE_BITS = 20;
+        // bandwidth of the normal equations: a cubic B-spline overlaps 3 neighbours on each side
+        inline constexpr int FIT_BAND = 3;
+
+        // v * 2^-shift rounded, negative shift multiplies
+        constexpr int64_t fitShift(const int64_t v, const int shift) {
+            if (shift > 0) {
+                return (v + (int64_t{1} << (shift - 1))) >> shift;
+            }
+            assert(shift == 0 || (v < 0 ? -v : v) <= std::numeric_limits<int64_t>::max() >> -shift);
+            return v * (int64_t{1} << -shift);
+        }
+    }
+
+    /**
+     * Least squares fit of a smoothing cubic spline (P-spline, Eilers & Marx: Flexible smoothing with
+     * B-splines and penalties, 1996) to dense noisy samples. The curve has a given number of uniform segments,
+     * so a million samples can be turned into a few dozen segments that are fast to evaluate.
+     *
+     * Samples are streamed through add: each one updates the banded normal equations of the uniform cubic
+     * B-spline basis in int64, so memory use depends on the segment count only. fit adds a second difference
+     * penalty weighted by the smoothing parameter and solves the system with banded LDLt decomposition
+     * in fixed point. Integer arithmetic only, the result is the same on every platform.
+     * Spans without samples follow the straight line between the data around them, and beyond
+     * the outermost samples the curve goes on as a line.
+     */
+    class SplineFitter {
+    public:
+        /**
+         * @param segments number of uniform segments of the fitted curve, 1...32767
+         * @param xMin domain start, samples outside of the domain are clamped to it
+         * @param xMax domain end, greater than xMin
+         * @param yMin min of sample values, used for normalization; values outside of [yMin...yMax] are clamped
+         * @param yMax max of sample values
+         * @throws std::invalid_argument if the segment count is out of range or a bound range is empty
+         */
+        SplineFitter(const int segments, const Dec16 xMin, const Dec16 xMax, const Dec16 yMin, const Dec16 yMax)
+            : mSegments(segments),
+              mXMin(xMin),
+              mXMax(xMax),
+              mYMin(yMin),
+              mYMax(yMax) {
+            // samples are placed by dividing by the x range, release builds must not get here with an empty one
+            if (segments < 1 || segments > std::numeric_limits<int16_t>::max()) {
+                throw std::invalid_argument("SplineFitter: segment count out of range");
+            }
+            if (xMin >= xMax || yMin > yMax) {
+                throw std::invalid_argument("SplineFitter: empty domain or value range");
+            }
+            mNormal.resize(segments + Internal::FIT_BAND);
+            mRhs.resize(segments + Internal::FIT_BAND);
+        }
+
+        void add(const Dec16 x, const Dec16 y) {
+            using namespace Internal;
+            constexpr int64_t one = int64_t{1} << FIT_WEIGHT_BITS;
+
+            // segment and position in it, exact in int64
+            const int64_t range = int64_t{mXMax.raw_value()} - mXMin.raw_value();
+            const int64_t dx = std::clamp(int64_t{x.raw_value()} - mXMin.raw_value(), int64_t{0}, range);
+            const int64_t pos = dx * mSegments;
+            auto segment = static_cast<int>(pos / range);
+            int64_t u = ((pos % range) << FIT_WEIGHT_BITS) / range;
+            if (segment == mSegments) {
+                segment--;
+                u = one;
+            }
+
+            // uniform cubic B-spline basis, sum of weights is exactly one
+            const int64_t v = one - u;
+            const int64_t u2 = u * u;
+            const int64_t u3 = u2 * u;
+            auto toWeight = [](const int64_t w) {
+                constexpr int64_t div = int64_t{6} << (2 * FIT_WEIGHT_BITS);
+                return (w + div / 2) / div;
+            };
+            std::array<int64_t, 4> w{};
+            w[0] = toWeight(v * v * v);
+            w[1] = toWeight(3 * u3 - 6 * u2 * one + 4 * one * one * one);
+            w[3] = toWeight(u3);
+            w[2] = one - w[0] - w[1] - w[3];
+
+            // clamped value keeps yNorm within [0...1] and w * yNorm sums far from int64 overflow
+            const int64_t yRange = std::max(int64_t{1}, int64_t{mYMax.raw_value()} - mYMin.raw_value());
+            const int64_t dy = std::clamp(int64_t{y.raw_value()} - mYMin.raw_value(), int64_t{0}, yRange);
+            const int64_t yNorm = (dy << FIT_VALUE_BITS) / yRange;
+            for (int a = 0; a < 4; a++) {
+                std::array<int64_t, FIT_BAND + 1>& row = mNormal[segment + a];
+                for (int d = 0; a + d < 4; d++) {
+                    row[d] += w[a] * w[a + d];
+                }
+                mRhs[segment + a] += w[a] * yNorm;
+            }
+            mSampleCount++;
+        }
+
+        void add(const Dec16* xVals, const Dec16* yVals, const std::size_t count) {
+            TV_PROFILE_ZONE("SplineFitter::add");
+            for (std::size_t i = 0; i < count; i++) {
+                add(xVals[i], yVals[i]);
+            }
+        }
+
+        [[nodiscard]] std::size_t getSampleCount() const {
+            return mSampleCount;
+        }
+
+        /**
+         * Solves the accumulated system, can be called several times with different smoothing.
+         *
+         * @param smoothing weight of the curvature penalty relative to the samples: 0 is a least squares fit
+         * (FIT_MIN_SMOOTHING still applies), large values flatten the curve towards a straight line
+         * @param yScale normalized y scale of the result, see Interpolator
+         * @return fitted function over [xMin...xMax]
+         */
+        [[nodiscard]] PolynomialSplineFunction fit(const Dec16 smoothing, const Dec16 yScale = Dec16{15}) const {
+            TV_PROFILE_ZONE("SplineFitter::fit");
+            using namespace Internal;
+            assert(mSampleCount > 0);
+            const int n = mSegments + FIT_BAND;
+
+            std::vector<std::array<int64_t, FIT_BAND + 1>> normal = mNormal;
+            std::vector<int64_t> rhs = mRhs;
+            addPenalty(normal, rhs, max(smoothing, FIT_MIN_SMOOTHING));
+
+            // symmetric power of two scaling brings every diagonal element to [0.25...1], so fixed point
+            // keeps the same relative precision for densely and sparsely sampled parts of the curve
+            std::vector<int> rowShift(n);
+            int maxShift = std::numeric_limits<int>::min();
+            for (int i = 0; i < n; i++) {
+                assert(normal[i][0] > 0);
+                const int width = static_cast<int>(std::bit_width(static_cast<uint64_t>(normal[i][0])));
+                rowShift[i] = (width - FRACT_PRECISE_BITS + 1) >> 1;
+                maxShift = std::max(maxShift, rowShift[i]);
+            }
+            std::vector<std::array<DecPrecise, FIT_BAND + 1>> band(n);
+            std::vector<DecPrecise> solution(n);
+            for (int i = 0; i < n; i++) {
+                for (int d = 0; d <= FIT_BAND && i + d < n; d++) {
+                    band[i][d] = DecPrecise::from_raw_value(static_cast<int32_t>(
+                        fitShift(normal[i][d], rowShift[i] + rowShift[i + d])));
+                }
+                // values are scaled so that the solution stays within 8
+                const int valueShift = FIT_WEIGHT_BITS + FIT_VALUE_BITS - FRACT_PRECISE_BITS - 9;
+                solution[i] = DecPrecise::from_raw_value(static_cast<int32_t>(
+                    fitShift(rhs[i], valueShift + rowShift[i] + maxShift)));
+            }
+
+            solveBanded(band, solution);
+
+            // B-spline coefficients of values normalized to [0...1] in Q24
+            std::vector<int64_t> coefs(n);
+            for (int i = 0; i < n; i++) {
+                coefs[i] = fitShift(solution[i].raw_value(), 3 + rowShift[i] - maxShift);
+            }
+            return toPolynomials(coefs, yScale);
+        }
+
+    private:
+        int mSegments;
+        Dec16 mXMin;
+        Dec16 mXMax;
+        Dec16 mYMin;
+        Dec16 mYMax;
+        // upper band of the symmetric normal matrix: mNormal[i][d] = A(i, i + d), basis weights in Q15 squared
+        std::vector<std::array<int64_t, Internal::FIT_BAND + 1>> mNormal;
+        // right hand side, weights times normalized values
+        std::vector<int64_t> mRhs;
+        std::size_t mSampleCount = 0;
+
+        // adds smoothing * mean diagonal * DtD, D is the second difference operator, and a tiny first difference ridge
+        static void addPenalty(std::vector<std::array<int64_t, Internal::FIT_BAND + 1>>& normal,
+                               std::vector<int64_t>& rhs, const Dec16 smoothing) {
+            using namespace Internal;
+            const int n = static_cast<int>(normal.size());
+            int64_t diagSum = 0;
+            for (const auto& row: normal) {
+                diagSum += row[0];
+            }
+            // drop low bits of both sides when the mean diagonal is too large to be multiplied by smoothing
+            const int64_t meanDiag = std::max(int64_t{1}, diagSum / n);
+            const int drop = std::max(0, static_cast<int>(std::bit_width(static_cast<uint64_t>(meanDiag))) - 30);
+            for (int i = 0; i < n; i++) {
+                for (int64_t& a: normal[i]) {
+                    a = fitShift(a, drop);
+                }
+                rhs[i] = fitShift(rhs[i], drop);
+            }
+
+            const int64_t weight = std::max(int64_t{1}, fitShift(fitShift(meanDiag, drop) * smoothing.raw_value(),
+                                                                 FRACT_16_BITS));
+            // rows of D are (1, -2, 1), DtD has the bandwidth 2
+            constexpr int64_t diff2[3] = {1, -2, 1};
+            for (int r = 0; r + 2 < n; r++) {
+                for (int a = 0; a < 3; a++) {
+                    for (int b = a; b < 3; b++) {
+                        normal[r + a][b - a] += weight * diff2[a] * diff2[b];
+                    }
+                }
+            }
+            // Tiny ridge keeps the matrix positive definite if samples don't pin down even a straight line.
+            // It penalizes first differences, not values: between samples it agrees with the curvature
+            // penalty on the straight line, where a value ridge would pull long empty spans towards yMin.
+            const int64_t ridge = std::max(int64_t{1}, meanDiag >> (24 + drop));
+            for (int r = 0; r + 1 < n; r++) {
+                normal[r][0] += ridge;
+                normal[r + 1][0] += ridge;
+                normal[r][1] -= ridge;
+            }
+        }
+
+        // solves A x = b in place of b, A is given by its upper band and is decomposed as L D Lt
+        static void solveBanded(const std::vector<std::array<DecPrecise, Internal::FIT_BAND + 1>>& band,
+                                std::vector<DecPrecise>& x) {
+            using namespace Internal;
+            const int n = static_cast<int>(band.size());
+            // lower[i][k] = L(i, i - k - 1)
+            std::vector<std::array<DecPrecise, FIT_BAND>> lower(n);
+            std::vector<DecPrecise> diag(n);
+            for (int i = 0; i < n; i++) {
+                const int first = std::max(0, i - FIT_BAND);
+                for (int j = first; j < i; j++) {
+                    DecPrecise s = band[j][i - j];
+                    for (int m = first; m < j; m++) {
+                        s -= lower[i][i - m - 1] * lower[j][j - m - 1] * diag[m];
+                    }
+                    lower[i][i - j - 1] = s / diag[j];
+                }
+                DecPrecise d = band[i][0];
+                for (int m = first; m < i; m++) {
+                    const DecPrecise l = lower[i][i - m - 1];
+                    d -= l * l * diag[m];
+                }
+                assert(d > DecPrecise{0});
+                diag[i] = d;
+            }
+
+            for (int i = 0; i < n; i++) {
+                for (int m = std::max(0, i - FIT_BAND); m < i; m++) {
+                    x[i] -= lower[i][i - m - 1] * x[m];
+                }
+            }
+            for (int i = 0; i < n; i++) {
+                x[i] /= diag[i];
+            }
+            for (int i = n - 1; i >= 0; i--) {
+                for (int k = 1; k <= FIT_BAND && i + k < n; k++) {
+                    x[i] -= lower[i + k][k - 1] * x[i + k];
+                }
+            }
+        }
+
+        // power basis polynomials of unit wide segments, so coefficients don't grow with the segment count
+        [[nodiscard]] PolynomialSplineFunction toPolynomials(const std::vector<int64_t>& coefs,
+                                                             const Dec16 yScale) const {
+            const int64_t scale = yScale.raw_value();
+            // coefficients are Q24, result is Q16: num * yScale / (den * 2^24)
+            auto toDec16 = [scale](const int64_t num, const int64_t den) {
+                const int64_t div = den << FRACT_PRECISE_BITS;
+                const int64_t v = num * scale;
+                return Dec16::from_raw_value(static_cast<int32_t>((v >= 0 ? v + div / 2 : v - div / 2) / div));
+            };
+            std::vector<Dec16> knots(mSegments + 1);
+            std::vector<std::vector<Dec16>> polynomials(mSegments);
+            for (int j = 0; j <= mSegments; j++) {
+                knots[j] = Dec16{j};
+            }
+            for (int j = 0; j < mSegments; j++) {
+                const int64_t c0 = coefs[j];
+                const int64_t c1 = coefs[j + 1];
+                const int64_t c2 = coefs[j + 2];
+                const int64_t c3 = coefs[j + 3];
+                polynomials[j] = {
+                    toDec16(c0 + 4 * c1 + c2, 6),
+                    toDec16(c2 - c0, 2),
+                    toDec16(c0 - 2 * c1 + c2, 2),
+                    toDec16(-c0 + 3 * c1 - 3 * c2 + c3, 6),
+                };
+            }
+            return PolynomialSplineFunction(std::move(knots), std::move(polynomials), Dec16{mSegments}, yScale,
+                                            mXMin, mXMax, mYMin, mYMax);
+        }
+    };
+
+    /**
+     * Fits a smoothing spline to the samples, see SplineFitter.
+     *
+     * @param xVals sample coordinates, in any order
+     * @param yVals sample values
+     * @param segments number of uniform segments of the result
+     * @param smoothing weight of the curvature penalty, 0 for a least squares fit
+     * @param yScale normalized y scale of the result, see Interpolator
+     * @return fitted function over the range of xVals, a unit wide domain at x if all samples are at x
+     */
+    inline PolynomialSplineFunction fitSpline(const std::vector<Dec16>& xVals, const std::vector<Dec16>& yVals,
+                                              const int segments, const Dec16 smoothing,
+                                              const Dec16 yScale = Dec16{15}) {
+        assert(xVals.size() == yVals.size() && !xVals.empty());
+        const auto [xMinIt, xMaxIt] = std::minmax_element(xVals.begin(), xVals.end());
+        const auto [yMin, yMax] = std::minmax_element(yVals.begin(), yVals.end());
+        // all samples at one x, where Interpolator maps them to xMin: one point doesn't give a slope,
+        // so they are repeated at the other end of a unit wide domain and the result is their mean
+        const bool isSinglePoint = *xMinIt == *xMaxIt;
+        // the domain grows towards zero, so it can't overflow
+        const Dec16 other = *xMinIt > Dec16{0} ? *xMinIt - Dec16{1} : *xMinIt + Dec16{1};
+        const Dec16 xMin = isSinglePoint ? std::min(*xMinIt, other) : *xMinIt;
+        const Dec16 xMax = isSinglePoint ? std::max(*xMaxIt, other) : *xMaxIt;
+        SplineFitter fitter(segments, xMin, xMax, *yMin, *yMax);
+        fitter.add(xVals.data(), yVals.data(), xVals.size());
+        if (isSinglePoint) {
+            for (const Dec16 y: yVals) {
+                fitter.add(other, y);
+            }
+        }
+        return fitter.fit(smoothing, yScale);
+    }
+}
@@ -0,0 +1,470 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "mappedFile.h"
+#include "spline.h"
+
+namespace TV::Math {
+    /*
+     * Binary spline file. All numbers are little endian, Dec16 is stored as its int32 raw value.
+     *   header: char[4] magic "TVSP", uint32 version, uint32 spline count, uint32 reserved
+     *   uint64 file offset of every spline record
+     *   records, 4 byte aligned, each starting with uint32 SplineRecordType:
+     *     polynomial: uint32 segment count n, uint32 coefficients per segment m,
+     *                 Dec16 xScale, yScale, origXMin, origXMax, origYMin, origYMax,
+     *                 Dec16 knots[n + 1], Dec16 coefficients[n * m]
+     *     parametric 2D: Dec16 xMin, xMax, yMin, yMax, uint32 t knot count k, Dec16 tKnots[k],
+     *                 x polynomial and y polynomial bodies (polynomial record without the type)
+     * Readers map the file and evaluate splines straight from the mapped memory.
+     */
+    inline constexpr char SPLINE_FILE_MAGIC[4] = {'T', 'V', 'S', 'P'};
+    inline constexpr uint32_t SPLINE_FILE_VERSION = 1;
+
+    enum class SplineRecordType : uint32_t {
+        Polynomial = 0,
+        Parametric2D = 1,
+    };
+
+    // Collects splines and writes them to a spline file
+    class SplineFileWriter {
+    public:
+        void add(const PolynomialSplineFunction& spline) {
+            mOffsets.push_back(mRecords.size());
+            put(static_cast<uint32_t>(SplineRecordType::Polynomial));
+            putPolynomial(spline);
+        }
+
+        void add(const Parametric2DPolynomialSplineFunction& spline) {
+            mOffsets.push_back(mRecords.size());
+            put(static_cast<uint32_t>(SplineRecordType::Parametric2D));
+            put(spline.getXMin());
+            put(spline.getXMax());
+            put(spline.getYMin());
+            put(spline.getYMax());
+            put(static_cast<uint32_t>(spline.getTKnots().size()));
+            for (const Dec16 t: spline.getTKnots()) {
+                put(t);
+            }
+            putPolynomial(spline.getXFunc());
+            putPolynomial(spline.getYFunc());
+        }
+
+        /**
+         * Writes all added splines.
+         *
+         * @param path output file path
+         * @return true if the file was written
+         */
+        bool write(const std::filesystem::path& path) const {
+            std::vector<std::byte> header;
+            header.insert(header.end(), reinterpret_cast<const std::byte*>(SPLINE_FILE_MAGIC),
+                          reinterpret_cast<const std::byte*>(SPLINE_FILE_MAGIC) + sizeof(SPLINE_FILE_MAGIC));
+            putLE(header, SPLINE_FILE_VERSION);
+            putLE(header, static_cast<uint32_t>(mOffsets.size()));
+            putLE(header, uint32_t{0});
+            const uint64_t recordsStart = header.size() + mOffsets.size() * sizeof(uint64_t);
+            for (const uint64_t offset: mOffsets) {
+                putLE(header, static_cast<uint32_t>(recordsStart + offset));
+                putLE(header, static_cast<uint32_t>((recordsStart + offset) >> 32));
+            }
+
+            std::ofstream out(path, std::ios::binary);
+            if (!out) {
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+            out.write(reinterpret_cast<const char*>(mRecords.data()), static_cast<std::streamsize>(mRecords.size()));
+            return static_cast<bool>(out);
+        }
+
+    private:
+        std::vector<std::byte> mRecords;
+        // record offsets from the start of records
+        std::vector<uint64_t> mOffsets;
+
+        static void putLE(std::vector<std::byte>& bytes, const uint32_t v) {
+            for (int i = 0; i < 4; i++) {
+                bytes.push_back(static_cast<std::byte>(v >> (8 * i)));
+            }
+        }
+
+        void put(const uint32_t v) {
+            putLE(mRecords, v);
+        }
+
+        void put(const Dec16 v) {
+            putLE(mRecords, static_cast<uint32_t>(v.raw_value()));
+        }
+
+        void putPolynomial(const PolynomialSplineFunction& spline) {
+            const std::vector<std::vector<Dec16>>& polynomials = spline.getPolynomials();
+            const std::size_t coefficientNum = polynomials.front().size();
+            put(static_cast<uint32_t>(polynomials.size()));
+            put(static_cast<uint32_t>(coefficientNum));
+            put(spline.getXScale());
+            put(spline.getYScale());
+            put(spline.getCoordMin());
+            put(spline.getCoordMax());
+            put(spline.getOrigYMin());
+            put(spline.getOrigYMax());
+            for (const Dec16 knot: spline.getKnots()) {
+                put(knot);
+            }
+            for (const std::vector<Dec16>& polynomial: polynomials) {
+                assert(polynomial.size() == coefficientNum);
+                for (const Dec16 c: polynomial) {
+                    put(c);
+                }
+            }
+        }
+    };
+
+    /**
+     * Polynomial spline that reads knots and coefficients from spline file memory.
+     * Gives the same results as PolynomialSplineFunction it was written from.
+     * Valid while its SplineFile is open.
+     */
+    class MappedPolynomialSplineFunction final : public SplineFunction {
+    public:
+        [[nodiscard]] std::pair<Dec16, Dec16> value(const Dec16 coord) const override {
+            const Dec16 xNorm = rescale(coord, mOrigXMin, mOrigXMax, Dec16{0}, mXScale);
+            return std::pair{coord, valueNorm(xNorm, mOrigYMin, mOrigYMax)};
+        }
+
+        [[nodiscard]] Dec16 valueNorm(const Dec16 xNorm, const Dec16 resMin, const Dec16 resMax) const {
+            const int i = findSegment(xNorm);
+            const Dec16 r = PolynomialSplineFunction::interpPolynomial(
+                mCoefficients + i * mCoefficientNum, mCoefficientNum, xNorm - mKnots[i]);
+            return rescale(r, Dec16{0}, mYScale, resMin, resMax);
+        }
+
+        [[nodiscard]] std::pair<Dec16, Dec16> tangent(const Dec16 coord) const override {
+            const Dec16 xNorm = rescale(coord, mOrigXMin, mOrigXMax, Dec16{0}, mXScale);
+            return std::pair{
+                (mOrigXMax - mOrigXMin) / mXScale,
+                derivativeNorm(xNorm, mOrigYMin, mOrigYMax)
+            };
+        }
+
+        [[nodiscard]] Dec16 derivativeNorm(const Dec16 xNorm, const Dec16 resMin, const Dec16 resMax) const {
+            const int i = findSegment(xNorm);
+            const Dec16 r = PolynomialSplineFunction::interpPolynomialDerivative(
+                mCoefficients + i * mCoefficientNum, mCoefficientNum, xNorm - mKnots[i]);
+            return r * ((resMax - resMin) / mYScale);
+        }
+
+        [[nodiscard]] Dec16 getCoordMin() const override {
+            return mOrigXMin;
+        }
+
+        [[nodiscard]] Dec16 getCoordMax() const override {
+            return mOrigXMax;
+        }
+
+        [[nodiscard]] int getClosestKnotIndex(const Dec16 coord) const override {
+            return lowerBound(rescale(coord, mOrigXMin, mOrigXMax, Dec16{0}, mXScale));
+        }
+
+    private:
+        friend class SplineFile;
+        friend class MappedParametric2DSplineFunction;
+
+        int mSegmentNum = 0;
+        int mCoefficientNum = 0;
+        const Dec16* mKnots = nullptr;
+        const Dec16* mCoefficients = nullptr;
+        Dec16 mXScale;
+        Dec16 mYScale;
+        Dec16 mOrigXMin;
+        Dec16 mOrigXMax;
+        Dec16 mOrigYMin;
+        Dec16 mOrigYMax;
+
+        MappedPolynomialSplineFunction() = default;
+
+        // same as binSearch over the knots
+        [[nodiscard]] int lowerBound(const Dec16 x) const {
+            const Dec16* end = mKnots + mSegmentNum + 1;
+            const Dec16* it = std::lower_bound(mKnots, end, x);
+            return it == end ? -1 : static_cast<int>(it - mKnots);
+        }
+
+        // segment index chosen the same way as PolynomialSplineFunction does
+        [[nodiscard]] int findSegment(const Dec16 xNorm) const {
+            assert(xNorm >= mKnots[0]);
+            assert(xNorm <= mKnots[mSegmentNum]);
+            const int i = lowerBound(xNorm);
+            assert(i >= 0);
+            return i > 0 ? i - 1 : 0;
+        }
+    };
+
+    /**
+     * Parametric 2D spline that reads its data from spline file memory.
+     * Gives the same results as Parametric2DPolynomialSplineFunction it was written from.
+     * Valid while its SplineFile is open.
+     */
+    class MappedParametric2DSplineFunction final : public SplineFunction {
+    public:
+        [[nodiscard]] std::pair<Dec16, Dec16> value(const Dec16 coord) const override {
+            return std::pair{mXFunc.valueNorm(coord, mXMin, mXMax), mYFunc.valueNorm(coord, mYMin, mYMax)};
+        }
+
+        [[nodiscard]] std::pair<Dec16, Dec16> tangent(const Dec16 coord) const override {
+            return std::pair{mXFunc.derivativeNorm(coord, mXMin, mXMax), mYFunc.derivativeNorm(coord, mYMin, mYMax)};
+        }
+
+        [[nodiscard]] Dec16 getCoordMin() const override {
+            return mTKnots[0];
+        }
+
+        [[nodiscard]] Dec16 getCoordMax() const override {
+            return mTKnots[mTKnotNum - 1];
+        }
+
+        [[nodiscard]] int getClosestKnotIndex(const Dec16 coord) const override {
+            const Dec16* end = mTKnots + mTKnotNum;
+            const Dec16* it = std::lower_bound(mTKnots, end, coord);
+            return it == end ? -1 : static_cast<int>(it - mTKnots);
+        }
+
+    private:
+        friend class SplineFile;
+
+        MappedPolynomialSplineFunction mXFunc;
+        MappedPolynomialSplineFunction mYFunc;
+        int mTKnotNum = 0;
+        const Dec16* mTKnots = nullptr;
+        Dec16 mXMin;
+        Dec16 mXMax;
+        Dec16 mYMin;
+        Dec16 mYMax;
+
+        MappedParametric2DSplineFunction() = default;
+    };
+
+    /**
+     * Memory-mapped spline file. Opening maps the file and validates every record, which reads each knot
+     * once to check the order, so it costs O(total knots). Nothing is parsed or copied: splines are views
+     * into the mapping.
+     */
+    class SplineFile {
+    public:
+        /**
+         * Maps and validates the file: record bounds, scales and knot order, O(total knots).
+         *
+         * @param path spline file path
+         * @return true if the file is a valid spline file
+         */
+        bool open(const std::filesystem::path& path) {
+            close();
+            // splines are evaluated straight from little endian file data
+            if constexpr (std::endian::native != std::endian::little) {
+                return false;
+            }
+            if (!mFile.open(path, MappedFile::Mode::Read) || mFile.getSize() < HEADER_SIZE) {
+                return false;
+            }
+            mData = mFile.map(0, mFile.getSize());
+            if (mData == nullptr || std::memcmp(mData, SPLINE_FILE_MAGIC, sizeof(SPLINE_FILE_MAGIC)) != 0
+                || load32(4) != SPLINE_FILE_VERSION) {
+                close();
+                return false;
+            }
+            mCount = static_cast<int>(load32(8));
+            if (HEADER_SIZE + uint64_t{load32(8)} * sizeof(uint64_t) > mFile.getSize()) {
+                close();
+                return false;
+            }
+            for (int i = 0; i < mCount; i++) {
+                if (!isValidRecord(getOffset(i))) {
+                    close();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void close() {
+            mFile.close();
+            mData = nullptr;
+            mCount = 0;
+        }
+
+        [[nodiscard]] int getCount() const {
+            return mCount;
+        }
+
+        [[nodiscard]] SplineRecordType getType(const int i) const {
+            assert(i >= 0 && i < mCount);
+            return static_cast<SplineRecordType>(load32(getOffset(i)));
+        }
+
+        [[nodiscard]] MappedPolynomialSplineFunction getPolynomial(const int i) const {
+            assert(getType(i) == SplineRecordType::Polynomial);
+            MappedPolynomialSplineFunction spline;
+            readPolynomial(getOffset(i) + 4, spline);
+            return spline;
+        }
+
+        [[nodiscard]] MappedParametric2DSplineFunction getParametric2D(const int i) const {
+            assert(getType(i) == SplineRecordType::Parametric2D);
+            uint64_t offset = getOffset(i) + 4;
+            MappedParametric2DSplineFunction spline;
+            spline.mXMin = loadDec(offset);
+            spline.mXMax = loadDec(offset + 4);
+            spline.mYMin = loadDec(offset + 8);
+            spline.mYMax = loadDec(offset + 12);
+            spline.mTKnotNum = static_cast<int>(load32(offset + 16));
+            spline.mTKnots = decArray(offset + 20);
+            offset += 20 + uint64_t{load32(offset + 16)} * 4;
+            offset = readPolynomial(offset, spline.mXFunc);
+            readPolynomial(offset, spline.mYFunc);
+            return spline;
+        }
+
+        [[nodiscard]] std::unique_ptr<SplineFunction> getSpline(const int i) const {
+            if (getType(i) == SplineRecordType::Polynomial) {
+                return std::make_unique<MappedPolynomialSplineFunction>(getPolynomial(i));
+            }
+            return std::make_unique<MappedParametric2DSplineFunction>(getParametric2D(i));
+        }
+
+    private:
+        static constexpr uint64_t HEADER_SIZE = 16;
+        // type, segment and coefficient counts, 6 scale and bound values
+        static constexpr uint64_t POLYNOMIAL_HEADER_SIZE = 8 + 6 * 4;
+
+        MappedFile mFile;
+        const std::byte* mData = nullptr;
+        int mCount = 0;
+
+        [[nodiscard]] uint32_t load32(const uint64_t offset) const {
+            uint32_t v;
+            std::memcpy(&v, mData + offset, sizeof(v));
+            return v;
+        }
+
+        [[nodiscard]] Dec16 loadDec(const uint64_t offset) const {
+            return Dec16::from_raw_value(static_cast<int32_t>(load32(offset)));
+        }
+
+        [[nodiscard]] const Dec16* decArray(const uint64_t offset) const {
+            static_assert(sizeof(Dec16) == 4 && std::is_trivially_copyable_v<Dec16>);
+            return reinterpret_cast<const Dec16*>(mData + offset);
+        }
+
+        [[nodiscard]] uint64_t getOffset(const int i) const {
+            const uint64_t at = HEADER_SIZE + static_cast<uint64_t>(i) * sizeof(uint64_t);
+            return load32(at) | (uint64_t{load32(at + 4)} << 32);
+        }
+
+        // reads polynomial body at offset, returns the offset after it
+        uint64_t readPolynomial(const uint64_t offset, MappedPolynomialSplineFunction& spline) const {
+            const uint32_t segmentNum = load32(offset);
+            const uint32_t coefficientNum = load32(offset + 4);
+            spline.mSegmentNum = static_cast<int>(segmentNum);
+            spline.mCoefficientNum = static_cast<int>(coefficientNum);
+            spline.mXScale = loadDec(offset + 8);
+            spline.mYScale = loadDec(offset + 12);
+            spline.mOrigXMin = loadDec(offset + 16);
+            spline.mOrigXMax = loadDec(offset + 20);
+            spline.mOrigYMin = loadDec(offset + 24);
+            spline.mOrigYMax = loadDec(offset + 28);
+            const uint64_t knotsOffset = offset + POLYNOMIAL_HEADER_SIZE;
+            spline.mKnots = decArray(knotsOffset);
+            const uint64_t coefficientsOffset = knotsOffset + (uint64_t{segmentNum} + 1) * 4;
+            spline.mCoefficients = decArray(coefficientsOffset);
+            return coefficientsOffset + uint64_t{segmentNum} * coefficientNum * 4;
+        }
+
+        // size of a polynomial body at offset, 0 if it doesn't fit in the file
+        [[nodiscard]] uint64_t polynomialSize(const uint64_t offset) const {
+            if (offset + POLYNOMIAL_HEADER_SIZE > mFile.getSize()) {
+                return 0;
+            }
+            const uint64_t segmentNum = load32(offset);
+            const uint64_t coefficientNum = load32(offset + 4);
+            if (segmentNum == 0 || coefficientNum == 0 || segmentNum > INT32_MAX / coefficientNum) {
+                return 0;
+            }
+            const uint64_t size = POLYNOMIAL_HEADER_SIZE + (segmentNum + 1 + segmentNum * coefficientNum) * 4;
+            return offset + size <= mFile.getSize() ? size : 0;
+        }
+
+        [[nodiscard]] bool isSorted(const uint64_t offset, const uint64_t count) const {
+            const Dec16* values = decArray(offset);
+            return std::is_sorted(values, values + count);
+        }
+
+        // checks values of a polynomial body that fits in the file: evaluation of normalized x in
+        // [coverMin...coverMax] must not divide by zero or fall outside of the knots
+        [[nodiscard]] bool isValidPolynomial(const uint64_t offset, const Dec16 coverMin, const Dec16 coverMax) const {
+            const uint64_t segmentNum = load32(offset);
+            const uint64_t knotsOffset = offset + POLYNOMIAL_HEADER_SIZE;
+            const Dec16* knots = decArray(knotsOffset);
+            return loadDec(offset + 12) > Dec16{0}
+                   && isSorted(knotsOffset, segmentNum + 1)
+                   && knots[0] <= coverMin && knots[segmentNum] >= coverMax;
+        }
+
+        // standalone polynomial also maps its original x range to the knots
+        [[nodiscard]] bool isValidStandalonePolynomial(const uint64_t offset) const {
+            const Dec16 xScale = loadDec(offset + 8);
+            const Dec16 origXMin = loadDec(offset + 16);
+            const Dec16 origXMax = loadDec(offset + 20);
+            // flat functions have equal y bounds
+            if (xScale <= Dec16{0} || origXMin >= origXMax || loadDec(offset + 24) > loadDec(offset + 28)) {
+                return false;
+            }
+            // rescale to [0...xScale] must not overflow, it divides by the range or multiplies by xScale / range
+            const int64_t range = int64_t{origXMax.raw_value()} - origXMin.raw_value();
+            if (range > INT32_MAX
+                || (origXMax <= xScale && int64_t{xScale.raw_value()} * (int64_t{1} << 16) / range > INT32_MAX)) {
+                return false;
+            }
+            const Dec16 xNormMax = rescale(origXMax, origXMin, origXMax, Dec16{0}, xScale);
+            return decArray(offset + POLYNOMIAL_HEADER_SIZE)[0] == Dec16{0}
+                   && isValidPolynomial(offset, Dec16{0}, xNormMax);
+        }
+
+        [[nodiscard]] bool isValidRecord(const uint64_t offset) const {
+            if (offset % 4 != 0 || offset + 4 > mFile.getSize()) {
+                return false;
+            }
+            const uint32_t type = load32(offset);
+            if (type == static_cast<uint32_t>(SplineRecordType::Polynomial)) {
+                return polynomialSize(offset + 4) != 0 && isValidStandalonePolynomial(offset + 4);
+            }
+            if (type != static_cast<uint32_t>(SplineRecordType::Parametric2D) || offset + 24 > mFile.getSize()) {
+                return false;
+            }
+            const uint64_t tKnotNum = load32(offset + 20);
+            if (tKnotNum == 0 || tKnotNum > INT32_MAX) {
+                return false;
+            }
+            const uint64_t xAt = offset + 24 + tKnotNum * 4;
+            const uint64_t xSize = polynomialSize(xAt);
+            if (xSize == 0) {
+                return false;
+            }
+            const uint64_t yAt = xAt + xSize;
+            if (polynomialSize(yAt) == 0 || !isSorted(offset + 24, tKnotNum)) {
+                return false;
+            }
+            // both coordinates are evaluated over the whole t range
+            const Dec16 tMin = loadDec(offset + 24);
+            const Dec16 tMax = loadDec(offset + 24 + (tKnotNum - 1) * 4);
+            return isValidPolynomial(xAt, tMin, tMax) && isValidPolynomial(yAt, tMin, tMax);
+        }
+    };
+}
@@ -0,0 +1,59 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <filesystem>
+#include <limits>
+#include <type_traits>
+
+#include "mappedFile.h"
+#include "spline.h"
+#include "threadPool.h"
+
+namespace TV::Math {
+    // elements mapped at a time by remapFile, bounds its memory use
+    inline constexpr std::size_t REMAP_WINDOW = std::size_t{1} << 24;
+    // elements per parallel task
+    inline constexpr int REMAP_GRAIN = 1 << 14;
+
+    /**
+     * Maps every value of a file through the spline: out[i] = func.value(in[i]).second, with values outside
+     * of the spline domain clamped to it. Files are memory-mapped window by window and the values are
+     * evaluated straight from the input mapping into the output mapping on threads of the pool,
+     * so memory use doesn't depend on the file size and nothing is copied.
+     *
+     * @param func transfer function
+     * @param inPath input file of native endian int32 raw Dec16 values
+     * @param outPath output file of the same layout, created or overwritten; must differ from the input
+     * @param pool thread pool evaluating the values
+     * @param windowElements number of values mapped at a time
+     * @return true on success
+     */
+    inline bool remapFile(const PolynomialSplineFunction& func, const std::filesystem::path& inPath,
+                          const std::filesystem::path& outPath, ThreadPool& pool,
+                          const std::size_t windowElements = REMAP_WINDOW) {
+        TV_PROFILE_ZONE("remapFile");
+        static_assert(sizeof(Dec16) == sizeof(int32_t) && std::is_trivially_copyable_v<Dec16>);
+        assert(windowElements > 0 && windowElements <= static_cast<std::size_t>(std::numeric_limits<int>::max()));
+        MappedFile in;
+        if (!in.open(inPath, MappedFile::Mode::Read) || in.getSize() % sizeof(Dec16) != 0) {
+            return false;
+        }
+        const uint64_t count = in.getSize() / sizeof(Dec16);
+        MappedFile out;
+        if (!out.open(outPath, MappedFile::Mode::Write, in.getSize())) {
+            return false;
+        }
+
+        for (uint64_t first = 0; first < count; first += windowElements) {
+            const auto n = static_cast<std::size_t>(std::min<uint64_t>(windowElements, count - first));
+            const auto* src = reinterpret_cast<const Dec16*>(in.map(first * sizeof(Dec16), n * sizeof(Dec16)));
+            auto* dst = reinterpret_cast<Dec16*>(out.map(first * sizeof(Dec16), n * sizeof(Dec16)));
+            if (src == nullptr || dst == nullptr) {
+                return false;
+            }
+            pool.parallelFor(static_cast<int>(n), REMAP_GRAIN, [=, &func](const int begin, const int end) {
+                func.values(src + begin, dst + begin, end - begin);
+            });
+        }
+        return true;
+    }
+}
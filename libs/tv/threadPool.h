@@ -0,0 +1,146 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TV {
+    /**
+     * Small pool of persistent worker threads for data-parallel loops.
+     * Threads are started once and sleep between jobs, so a parallel loop costs no thread startup.
+     * The calling thread takes part in the work. One job runs at a time, nested calls are not supported.
+     */
+    class ThreadPool {
+    public:
+        // threadCount includes the calling thread
+        explicit ThreadPool(const unsigned threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+            for (unsigned i = 1; i < threadCount; i++) {
+                mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock(mMutex);
+                mIsRunning = false;
+            }
+            mJobCv.notify_all();
+            for (std::thread& worker: mWorkers) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        [[nodiscard]] int getThreadCount() const {
+            return static_cast<int>(mWorkers.size()) + 1;
+        }
+
+        /**
+         * Splits [0...count) into contiguous chunks and calls func(begin, end) for each chunk in parallel.
+         * Returns when all chunks are done.
+         *
+         * @param count number of items
+         * @param grain chunk boundaries are multiples of grain
+         * @param func function processing items [begin...end)
+         */
+        void parallelFor(const int count, const int grain, const std::function<void(int, int)>& func) {
+            if (count <= 0) {
+                return;
+            }
+            const int grains = (count + grain - 1) / grain;
+            const int chunks = std::min(grains, getThreadCount());
+            if (chunks == 1) {
+                func(0, count);
+                return;
+            }
+
+            std::lock_guard submitLock(mSubmitMutex);
+            const auto job = std::make_shared<Job>();
+            job->func = [&func, count, grain, grains, chunks](const int chunk) {
+                // spread grains evenly, first chunks get one extra grain
+                const int begin = (grains / chunks * chunk + std::min(chunk, grains % chunks)) * grain;
+                const int end = (grains / chunks * (chunk + 1) + std::min(chunk + 1, grains % chunks)) * grain;
+                func(begin, std::min(end, count));
+            };
+            job->chunkCount = chunks;
+            {
+                std::lock_guard lock(mMutex);
+                mJob = job;
+                mJobGeneration++;
+            }
+            mJobCv.notify_all();
+
+            runChunks(*job);
+
+            std::unique_lock lock(mMutex);
+            mDoneCv.wait(lock, [&job] { return job->doneChunks == job->chunkCount; });
+            mJob = nullptr;
+        }
+
+    private:
+        struct Job {
+            std::function<void(int)> func;
+            int chunkCount = 0;
+            std::atomic<int> nextChunk{0};
+            // guarded by mMutex
+            int doneChunks = 0;
+        };
+
+        std::vector<std::thread> mWorkers;
+        // serializes jobs from different threads
+        std::mutex mSubmitMutex;
+        std::mutex mMutex;
+        std::condition_variable mJobCv;
+        std::condition_variable mDoneCv;
+        // current job, workers hold a reference, so a late worker only sees a job with no chunks left
+        std::shared_ptr<Job> mJob;
+        int mJobGeneration = 0;
+        bool mIsRunning = true;
+
+        // takes chunks of the job until none left
+        void runChunks(Job& job) {
+            int done = 0;
+            for (int chunk = job.nextChunk++; chunk < job.chunkCount; chunk = job.nextChunk++) {
+                job.func(chunk);
+                done++;
+            }
+            if (done > 0) {
+                {
+                    std::lock_guard lock(mMutex);
+                    job.doneChunks += done;
+                }
+                mDoneCv.notify_all();
+            }
+        }
+
+        void workerLoop() {
+            int seenGeneration = 0;
+            while (true) {
+                std::shared_ptr<Job> job;
+                {
+                    std::unique_lock lock(mMutex);
+                    mJobCv.wait(lock, [this, seenGeneration] {
+                        return !mIsRunning || mJobGeneration != seenGeneration;
+                    });
+                    if (!mIsRunning) {
+                        return;
+                    }
+                    seenGeneration = mJobGeneration;
+                    job = mJob;
+                }
+                // the job may be already finished and cleared by the time the worker wakes up
+                if (job != nullptr) {
+                    runChunks(*job);
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,116 @@
+// ReSharper disable CppUE4CodingStandardNamingViolationWarning
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "mappedFile.h"
+#include "tvmath.h"
+
+namespace TV::Math {
+    // default core tile size of the out-of-core blur
+    inline constexpr int BLUR_FILE_TILE = 1024;
+
+    /**
+     * Performs Gaussian blur of an image stored in a file, for images that don't fit in memory.
+     * The image is processed in tiles: every tile is read together with a halo of k1 + k2 + k3 elements
+     * (each box pass spreads edge clamping by its radius), blurred in memory and its core is written out.
+     * Peak memory depends on the tile size only and the result is identical to the in-memory gaussBlur.
+     *
+     * @param inPath input file with xSize * ySize native endian int32 values, row by row
+     * @param outPath output file of the same layout, created or overwritten; must differ from the input
+     * @param xSize data width
+     * @param ySize data height
+     * @param k1 radius for 1st kernel box
+     * @param k2 radius for 2nd kernel box
+     * @param k3 radius for 3rd kernel box
+     * @param tileSize tile core width and height
+     * @return true on success
+     */
+    inline bool gaussBlurFile(const std::filesystem::path& inPath, const std::filesystem::path& outPath,
+                              const int xSize, const int ySize, const int k1, const int k2, const int k3,
+                              const int tileSize = BLUR_FILE_TILE) {
+        TV_PROFILE_ZONE("gaussBlurFile");
+        assert(tileSize > 0);
+        const uint64_t rowBytes = static_cast<uint64_t>(xSize) * sizeof(int);
+        MappedFile in;
+        if (!in.open(inPath, MappedFile::Mode::Read) || in.getSize() != rowBytes * ySize) {
+            return false;
+        }
+        MappedFile out;
+        if (!out.open(outPath, MappedFile::Mode::Write, rowBytes * ySize)) {
+            return false;
+        }
+
+        const int halo = k1 + k2 + k3;
+        // box passes need the buffer wider than the box, tiles at the image border can be narrow
+        const int minSize = 2 * halo + 1;
+        // range of source elements [b0...b1) needed for the core [c0...c1)
+        auto haloRange = [halo, minSize](const int c0, const int c1, const int size) {
+            int b0 = std::max(0, c0 - halo);
+            int b1 = std::min(size, c1 + halo);
+            if (b1 - b0 < minSize) {
+                b0 = std::max(0, b1 - minSize);
+                b1 = std::min(size, b0 + minSize);
+            }
+            return std::pair{b0, b1};
+        };
+
+        std::vector<int> tile;
+        std::vector<int> scratch;
+        for (int y0 = 0; y0 < ySize; y0 += tileSize) {
+            const int y1 = std::min(ySize, y0 + tileSize);
+            const auto [by0, by1] = haloRange(y0, y1, ySize);
+            const int th = by1 - by0;
+            for (int x0 = 0; x0 < xSize; x0 += tileSize) {
+                const int x1 = std::min(xSize, x0 + tileSize);
+                const auto [bx0, bx1] = haloRange(x0, x1, xSize);
+                const int tw = bx1 - bx0;
+                tile.resize(static_cast<std::size_t>(tw) * th);
+                scratch.resize(tile.size());
+
+                // only rows of the tile are mapped, pages outside of its columns are not touched
+                const std::byte* src = in.map(by0 * rowBytes, th * rowBytes);
+                if (src == nullptr) {
+                    return false;
+                }
+                for (int y = 0; y < th; y++) {
+                    std::memcpy(tile.data() + y * tw, src + y * rowBytes + bx0 * sizeof(int), tw * sizeof(int));
+                }
+                in.unmap();
+
+                gaussBlur(tile.data(), scratch.data(), tw, th, k1, k2, k3);
+
+                std::byte* dst = out.map(y0 * rowBytes, (y1 - y0) * rowBytes);
+                if (dst == nullptr) {
+                    return false;
+                }
+                for (int y = y0; y < y1; y++) {
+                    std::memcpy(dst + (y - y0) * rowBytes + x0 * sizeof(int),
+                                tile.data() + (y - by0) * tw + (x0 - bx0), (x1 - x0) * sizeof(int));
+                }
+                out.unmap();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Performs Gaussian blur of an image stored in a file for given kernel radius, see gaussBlurFile above.
+     *
+     * @param inPath input file with xSize * ySize native endian int32 values, row by row
+     * @param outPath output file of the same layout, created or overwritten; must differ from the input
+     * @param xSize data width
+     * @param ySize data height
+     * @param radius kernel radius
+     * @param tileSize tile core width and height
+     * @return true on success
+     */
+    inline bool gaussBlurFile(const std::filesystem::path& inPath, const std::filesystem::path& outPath,
+                              const int xSize, const int ySize, const int radius,
+                              const int tileSize = BLUR_FILE_TILE) {
+        const auto [k1, k2, k3] = gaussBoxRadii(radius);
+        return gaussBlurFile(inPath, outPath, xSize, ySize, k1, k2, k3, tileSize);
+    }
+}
@@ -1,5 +1,7 @@
 #include "app.h"
 
+#include <cctype>
+#include <charconv>
 #include <ranges>
 
 #include "imgui.h"
@@ -9,9 +11,11 @@
 #include <SFML/Window/Event.hpp>
 #include "pointTransformer.h"
 #include "drawer.h"
+#include "pointParser.h"
 #include "pointUtils.h"
 #include "tv/spline.h"
-#include "textContainer.h"
+#include "tv/splineCodegen.h"
+#include "tv/profiler.h"
 #include "misc/cpp/imgui_stdlib.h"
 
 App::App(sf::RenderWindow& window)
@@ -28,6 +32,8 @@ App::App(sf::RenderWindow& window)
       mDrawer(Drawer(mWindow)) {
     mFrameContext.userPoints.push_back(Point{TV::Math::Dec16{0}, TV::Math::Dec16{0}});
     mFrameContext.userPoints.push_back(Point{TV::Math::Dec16{100}, TV::Math::Dec16{100}});
+    mFrameContext.pendingFrames = REDRAW_FRAMES;
+    mKnotIndex.rebuild(mWindowPoints, isParametric(mSplineType));
 }
 
 void App::initialPointsState() {
@@ -38,6 +44,8 @@ void App::initialPointsState() {
     mFrameContext.userPoints.clear();
     mFrameContext.userPoints.push_back(Point{TV::Math::Dec16{mUserCoords.xMin}, TV::Math::Dec16{mUserCoords.yMin}});
     mFrameContext.userPoints.push_back(Point{TV::Math::Dec16{mUserCoords.xMax}, TV::Math::Dec16{mUserCoords.yMax}});
+    onUserPointsChanged();
+    mKnotIndex.rebuild(mWindowPoints, isParametric(mSplineType));
 }
 
 void App::initialSettingsState() {
@@ -52,6 +60,9 @@ void App::initialSettingsState() {
     mResolution = 100;
     mSplineType = CubicMonotone;
     mIsRawValues = false;
+    mIsShowProfiler = false;
+    mIsOnDemandRendering = true;
+    mKnotIndex.rebuild(mWindowPoints, isParametric(mSplineType));
     refreshCoordinateSystem();
 }
 
@@ -60,23 +71,37 @@ void App::run() {
     using namespace TV::Math;
 
     while (mWindow.isOpen()) {
+        if (mIsOnDemandRendering) {
+            waitForRedraw();
+        }
+
         const std::vector<Point>& userKnots = getUserPoints();
-        const SplineFunction* spline = generateSpline(userKnots);
-        // intermediate points
-        std::vector<WindowPoint> points = generateIntermediatePoints(spline);
+        updateSpline(userKnots);
+        const SplineFunction* spline = mSplineResult != nullptr ? mSplineResult->spline.get() : nullptr;
         const Vector2i mousePos = Mouse::getPosition(mWindow);
         const int hoveringPoint = findPointUnderCursor(mousePos);
 
         ImGuiIO& io = ImGui::GetIO();
-        while (const std::optional eventOpt = mWindow.pollEvent()) {
-            if (eventOpt.has_value()) {
-                Event event = eventOpt.value();
-                ImGui::SFML::ProcessEvent(mWindow, event);
-                if (io.WantCaptureMouse || io.WantCaptureKeyboard) {
-                    // pass events to GUI
-                    continue;
+        const auto handleEvent = [&](const Event& event) {
+            // let GUI settle after any input
+            mFrameContext.pendingFrames = REDRAW_FRAMES;
+            ImGui::SFML::ProcessEvent(mWindow, event);
+            if (io.WantCaptureMouse || io.WantCaptureKeyboard) {
+                // pass events to GUI
+                return;
+            }
+            processWindowEvent(event, spline, hoveringPoint);
+        };
+        {
+            TV_PROFILE_ZONE("App::pollEvents");
+            if (mFrameContext.wakeEvent.has_value()) {
+                handleEvent(mFrameContext.wakeEvent.value());
+                mFrameContext.wakeEvent.reset();
+            }
+            while (const std::optional eventOpt = mWindow.pollEvent()) {
+                if (eventOpt.has_value()) {
+                    handleEvent(eventOpt.value());
                 }
-                processWindowEvent(event, spline, hoveringPoint);
             }
         }
 
@@ -85,22 +110,68 @@ void App::run() {
         mDrawer.setDrawRefLines(mIsDrawRefLines);
         mDrawer.setConPointSize(mConPointSize);
         mDrawer.setPointSize(mPointSize);
-        mDrawer.draw(mWindowPoints, points);
+        mDrawer.setLineThickness(mLineThickness);
+        if (mFrameContext.isUserModifiedPoints) {
+            // knots were moved by events of this frame, spline will catch up on the next one
+            mDrawer.setKnots(mWindowPoints);
+        }
+        mDrawer.draw();
+
+        {
+            TV_PROFILE_ZONE("ImGui");
+            ImGui::SFML::Update(mWindow, mFrameContext.deltaClock.restart());
+            drawGuiWidgets();
+            updateMouseTooltip(hoveringPoint, userKnots);
+            if (mIsShowProfiler) {
+                drawProfilerOverlay();
+            }
+            //ImGui::ShowDemoWindow();
+            ImGui::SFML::Render(mWindow);
+        }
+
+        {
+            TV_PROFILE_ZONE("App::display");
+            mWindow.display();
+        }
+
+        TV::Profiler::instance().endFrame();
+        if (mFrameContext.pendingFrames > 0) {
+            mFrameContext.pendingFrames--;
+        }
+    }
+}
 
-        ImGui::SFML::Update(mWindow, mFrameContext.deltaClock.restart());
-        drawGuiWidgets();
-        updateMouseTooltip(hoveringPoint, userKnots);
-        //ImGui::ShowDemoWindow();
-        ImGui::SFML::Render(mWindow);
+bool App::isRedrawRequired() const {
+    const ImGuiIO& io = ImGui::GetIO();
+    const bool isMouseDown = std::ranges::any_of(io.MouseDown, [](const bool isDown) { return isDown; });
+    return mFrameContext.pendingFrames > 0
+           // changes made by the last frame have to be shown
+           || mFrameContext.isUserModifiedPoints
+           || mFrameContext.isSplineDirty
+           || !isSplineUpToDate()
+           // ongoing interaction: drag, held GUI buttons and sliders
+           || mFrameContext.dragPointIdx != -1
+           || isMouseDown
+           || ImGui::IsAnyItemActive()
+           // animated overlay
+           || mIsShowProfiler;
+}
 
-        mWindow.display();
+void App::waitForRedraw() {
+    TV_PROFILE_ZONE("App::waitForRedraw");
 
-        delete spline;
+    if (isRedrawRequired()) {
+        return;
     }
+
+    // text input needs frames to blink the cursor, anything else sleeps until an event comes
+    const sf::Time timeout = ImGui::GetIO().WantTextInput ? sf::milliseconds(250) : sf::Time::Zero;
+    mFrameContext.wakeEvent = mWindow.waitEvent(timeout);
 }
 
 void App::processWindowEvent(const sf::Event& event, const TV::Math::SplineFunction* spline, const int hoveringPoint) {
     using namespace sf;
+    TV_PROFILE_ZONE("App::processWindowEvent");
 
     if (event.is<Event::Closed>()) {
         mWindow.close();
@@ -146,6 +217,8 @@ void App::drawGuiWidgets() {
         initialPointsState();
     }
     ImGui::Checkbox("Draw Reference Lines", &mIsDrawRefLines);
+    ImGui::Checkbox("Show Profiler", &mIsShowProfiler);
+    ImGui::Checkbox("Redraw On Demand", &mIsOnDemandRendering);
     const bool isParametricBefore = isParametric(mSplineType);
     if (ImGui::Combo("Spline Type", reinterpret_cast<int*>(&mSplineType),
                      "Linear\0Cubic\0Cubic Monotone\0Parametric\0")) {
@@ -153,8 +226,12 @@ void App::drawGuiWidgets() {
         if (isParametricBefore && !isParametricAfter) {
             initialPointsState();
         }
+        mKnotIndex.rebuild(mWindowPoints, isParametricAfter);
     }
     ImGui::InputInt("Point Size", &mPointSize);
+    if (ImGui::InputInt("Line Thickness", &mLineThickness)) {
+        mLineThickness = std::max(mLineThickness, 1);
+    }
 
     ImGui::Checkbox("Use Raw Values", &mIsRawValues);
     int yScale[2]{};
@@ -221,60 +298,187 @@ void App::drawGuiWidgets() {
     }
 
     ImGui::InputInt("Resolution", &mResolution);
-    const auto xyStrings = captureCurrentPoints();
-    TextContainer pointsText{};
-    TextContainer pointsCode{};
-    writeToContainer(pointsText,
-                     "X: {}", xyStrings.first,
-                     "Y: {}", xyStrings.second);
-
-    ImGui::Text("Points:");
-    ImGui::Indent();
-    ImGui::Text(pointsText.getContent());
-    ImGui::Unindent();
+    drawPointsTable();
     if (ImGui::Button("Copy X")) {
-        ImGui::SetClipboardText(xyStrings.first.c_str());
+        ImGui::SetClipboardText(getPointsText().first.c_str());
     }
     ImGui::SameLine();
     if (ImGui::Button("Copy Y")) {
-        ImGui::SetClipboardText(xyStrings.second.c_str());
+        ImGui::SetClipboardText(getPointsText().second.c_str());
     }
 
     static std::string loadX;
     static std::string loadY;
+    static std::string loadPath;
+    static std::string loadError;
     ImGui::InputText("Load X", &loadX);
     ImGui::InputText("Load Y", &loadY);
     if (ImGui::Button("Load Points")) {
-        setPoints(parsePoints(loadX, loadY));
+        loadPoints(SplGen::parsePoints(loadX, loadY, mIsRawValues), loadError);
+    }
+    ImGui::InputText("Points File", &loadPath);
+    if (ImGui::Button("Load File")) {
+        loadPoints(SplGen::parsePointsFile(loadPath, mIsRawValues), loadError);
+    }
+    if (!loadError.empty()) {
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "%s", loadError.c_str());
+    }
+
+    static std::string headerPath = "spline.h";
+    static std::string headerStatus;
+    ImGui::InputText("Header File", &headerPath);
+    if (ImGui::Button("Export Header")) {
+        headerStatus = exportSplineHeader(headerPath) ? "Exported" : "Export failed";
+    }
+    if (!headerStatus.empty()) {
+        ImGui::SameLine();
+        ImGui::Text("%s", headerStatus.c_str());
     }
 
     ImGui::End();
 }
 
-std::pair<std::string, std::string> App::captureCurrentPoints() {
-    std::ostringstream xStream;
-    std::ostringstream yStream;
-    for (int i = 0; i < mFrameContext.userPoints.size(); i++) {
-        auto [x, y] = mFrameContext.userPoints[i];
-        const int xVal = mIsRawValues ? x.raw_value() : TV::Math::toInt(x);
-        const int yVal = mIsRawValues ? y.raw_value() : TV::Math::toInt(y);
-
-        xStream << xVal;
-        yStream << yVal;
-        if (i + 1 < mFrameContext.userPoints.size()) {
-            xStream << ", ";
-            yStream << ", ";
+void App::drawProfilerOverlay() const {
+    TV::Profiler& profiler = TV::Profiler::instance();
+    const ImGuiIO& io = ImGui::GetIO();
+
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Text("Frame: %.2f ms (%.0f fps)", 1000.f / io.Framerate, io.Framerate);
+    const DrawStats& stats = mDrawer.getStats();
+    ImGui::Text("Draw calls: %d, vertices: %d", stats.drawCalls, stats.vertices);
+    ImGui::Separator();
+
+    // history is a ring buffer, offset points to the oldest value
+    const int offset = profiler.getHistoryOffset();
+    for (const TV::Profiler::ZoneHistory& zone: profiler.getZones()) {
+        const int lastIdx = (offset + TV::Profiler::HISTORY_SIZE - 1) % TV::Profiler::HISTORY_SIZE;
+        float maxMs = 0.f;
+        float sumMs = 0.f;
+        for (const float ms: zone.ms) {
+            maxMs = std::max(maxMs, ms);
+            sumMs += ms;
+        }
+        const std::string overlay = std::format("{:.3f} ms, avg {:.3f}, max {:.3f}",
+                                                zone.ms[lastIdx], sumMs / TV::Profiler::HISTORY_SIZE, maxMs);
+        ImGui::PlotLines(zone.name, zone.ms.data(), TV::Profiler::HISTORY_SIZE, offset,
+                         overlay.c_str(), 0.f, std::max(maxMs, 1.f), ImVec2(300, 40));
+    }
+    ImGui::Separator();
+
+    static std::string tracePath = "splinegen_trace.json";
+    static std::string traceError;
+    ImGui::InputText("Trace File", &tracePath);
+    if (profiler.isTraceCapturing()) {
+        if (ImGui::Button("Stop and Save Trace")) {
+            profiler.setTraceCapturing(false);
+            if (profiler.writeChromeTrace(tracePath)) {
+                profiler.clearTrace();
+                traceError.clear();
+            } else {
+                // failed save keeps the events and capturing, so it can be retried with another path
+                profiler.setTraceCapturing(true);
+                traceError = "Failed to write " + tracePath;
+            }
+        }
+        ImGui::SameLine();
+        ImGui::Text("%zu events", profiler.getTraceEventCount());
+    } else if (ImGui::Button("Start Trace")) {
+        profiler.clearTrace();
+        profiler.setTraceCapturing(true);
+    }
+    if (!traceError.empty()) {
+        ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "%s", traceError.c_str());
+    }
+    ImGui::End();
+}
+
+void App::drawPointsTable() const {
+    const std::vector<Point>& points = mFrameContext.userPoints;
+    ImGui::Text("Points: %zu", points.size());
+    const float height = ImGui::GetTextLineHeightWithSpacing() * POINTS_TABLE_ROWS;
+    if (!ImGui::BeginTable("Points", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                           ImVec2(0.f, height))) {
+        return;
+    }
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("#");
+    ImGui::TableSetupColumn("X");
+    ImGui::TableSetupColumn("Y");
+    ImGui::TableHeadersRow();
+
+    // only visible rows are formatted
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(points.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const auto [x, y] = points[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", i);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", mIsRawValues ? x.raw_value() : TV::Math::toInt(x));
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", mIsRawValues ? y.raw_value() : TV::Math::toInt(y));
+        }
+    }
+    ImGui::EndTable();
+}
+
+const std::pair<std::string, std::string>& App::getPointsText() {
+    FrameContext& context = mFrameContext;
+    if (!context.isPointsTextDirty && context.isPointsTextRaw == mIsRawValues) {
+        return context.pointsText;
+    }
+    TV_PROFILE_ZONE("App::getPointsText");
+
+    auto& [xText, yText] = context.pointsText;
+    xText.clear();
+    yText.clear();
+    // sign, 10 digits and the separator
+    constexpr std::size_t maxValueChars = 13;
+    xText.reserve(context.userPoints.size() * maxValueChars);
+    yText.reserve(context.userPoints.size() * maxValueChars);
+    const auto append = [](std::string& text, const int value, const bool isLast) {
+        char buff[maxValueChars];
+        char* end = std::to_chars(buff, buff + sizeof(buff), value).ptr;
+        if (!isLast) {
+            *end++ = ',';
+            *end++ = ' ';
         }
+        text.append(buff, end);
+    };
+    for (int i = 0; i < context.userPoints.size(); i++) {
+        const auto [x, y] = context.userPoints[i];
+        const bool isLast = i + 1 == context.userPoints.size();
+        append(xText, mIsRawValues ? x.raw_value() : TV::Math::toInt(x), isLast);
+        append(yText, mIsRawValues ? y.raw_value() : TV::Math::toInt(y), isLast);
     }
-    return std::pair{xStream.str(), yStream.str()};
+    context.isPointsTextDirty = false;
+    context.isPointsTextRaw = mIsRawValues;
+    return context.pointsText;
 }
 
-void App::writeToContainer(TextContainer& container,
-                           const std::string& xFormat, const std::string& xString,
-                           const std::string& yFormat, const std::string& yString) {
-    const std::string formattedX = std::vformat(xFormat, std::make_format_args(xString));
-    const std::string formattedY = std::vformat(yFormat, std::make_format_args(yString));
-    container.update(formattedX + "\n" + formattedY);
+bool App::exportSplineHeader(const std::string& path) const {
+    using namespace TV::Math;
+    if (mSplineResult == nullptr || mSplineResult->spline == nullptr) {
+        return false;
+    }
+    // namespace of the generated code is the file name made a valid identifier
+    std::string name = std::filesystem::path(path).stem().string();
+    std::ranges::replace_if(name, [](const unsigned char c) { return !std::isalnum(c); }, '_');
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+        name.insert(0, "spline_");
+    }
+
+    const SplineFunction* spline = mSplineResult->spline.get();
+    if (const auto* polynomial = dynamic_cast<const PolynomialSplineFunction*>(spline)) {
+        return writeSplineHeader(path, *polynomial, name);
+    }
+    if (const auto* parametric = dynamic_cast<const Parametric2DPolynomialSplineFunction*>(spline)) {
+        return writeSplineHeader(path, *parametric, name);
+    }
+    return false;
 }
 
 void App::refreshCoordinateSystem() {
@@ -282,42 +486,18 @@ void App::refreshCoordinateSystem() {
     mFrameContext.isUserModifiedPoints = true;
 }
 
-std::vector<Point> App::parsePoints(const std::string& xStr, const std::string& yStr) const {
-    std::string_view xView(xStr);
-    std::string_view yView(yStr);
-    std::vector<Point> result;
-    try {
-        std::vector<int> xVec;
-        for (const auto str: std::views::split(xView, ',')) {
-            xVec.push_back(std::stoi(str.data()));
-        }
-        std::vector<int> yVec;
-        for (const auto str: std::views::split(yView, ',')) {
-            yVec.push_back(std::stoi(str.data()));
-        }
-
-        if (xVec.size() == yVec.size()) {
-            for (int i = 0; i < xVec.size(); i++) {
-                TV::Math::Dec16 x;
-                TV::Math::Dec16 y;
-                if (mIsRawValues) {
-                    x = TV::Math::Dec16::from_raw_value(xVec[i]);
-                    y = TV::Math::Dec16::from_raw_value(yVec[i]);
-                } else {
-                    x = TV::Math::Dec16{xVec[i]};
-                    y = TV::Math::Dec16{yVec[i]};
-                }
-                result.emplace_back(x, y);
-            }
-        }
-    } catch (...) {
+void App::loadPoints(SplGen::PointParseResult result, std::string& error) {
+    // failed load keeps current points
+    error = std::move(result.error);
+    if (error.empty()) {
+        setPoints(result.points);
     }
-    return result;
 }
 
 void App::updateMouseTooltip(const int hoveringPoint, const std::vector<Point>& userKnots) const {
     const int pointIdx = mFrameContext.dragPointIdx != -1 ? mFrameContext.dragPointIdx : hoveringPoint;
-    if (pointIdx != -1) {
+    // GUI of this frame may have reset or loaded points, indices found before it can be out of date
+    if (pointIdx != -1 && pointIdx < static_cast<int>(userKnots.size())) {
         const Point point = userKnots[pointIdx];
         int x;
         int y;
@@ -337,52 +517,33 @@ void App::updateMouseTooltip(const int hoveringPoint, const std::vector<Point>&
 
 }
 
-TV::Math::SplineFunction* App::generateSpline(const std::vector<Point>& points) const {
-    using namespace TV::Math;
+void App::updateSpline(const std::vector<Point>& userKnots) {
+    const SplineSettings settings{mSplineType, mScale, mResolution};
+    if (mFrameContext.isSplineDirty || settings != mFrameContext.splineSettings) {
+        SplineRequest request{
+            mFrameContext.splineGeneration + 1, userKnots, settings, mUserCoords, mWindowCoords
+        };
+        // if the queue is full keep the dirty flag and try again on the next frame
+        if (mSplineWorker.submit(std::move(request))) {
+            mFrameContext.splineGeneration++;
+            mFrameContext.splineSettings = settings;
+            mFrameContext.isSplineDirty = false;
+            mDrawer.setKnots(mWindowPoints);
+        }
+    }
 
-    // transform point array to x/y arrays
-    std::vector<Dec16> x(points.size());
-    std::vector<Dec16> y(points.size());
-    std::transform(points.begin(), points.end(), x.begin(),
-                   [](const Point p) { return p.x; });
-    std::transform(points.begin(), points.end(), y.begin(),
-                   [](const Point p) { return p.y; });
-
-    const Interpolator interpolator(x, y, Dec16{mScale}, Dec16{mScale});
-
-    switch (mSplineType) {
-        case Cubic:
-            return new PolynomialSplineFunction(interpolator.interpolateNatural());
-        case CubicMonotone:
-            return new PolynomialSplineFunction(interpolator.interpolateAkima());
-        case Parametric:
-            return new Parametric2DPolynomialSplineFunction(interpolator.interpolate2D());
-        case Linear:
-        default:
-            return new PolynomialSplineFunction(interpolator.interpolateLinear());
+    if (const SplineResult* result = mSplineWorker.acquire()) {
+        mSplineResult = result;
+        mDrawer.setCurve(mSplineResult->samples);
     }
 }
 
-std::vector<WindowPoint> App::generateIntermediatePoints(const TV::Math::SplineFunction* spline) const {
-    using namespace TV::Math;
-
-    std::vector<WindowPoint> iPoints;
-    const Dec16 cMin = spline->getCoordMin();
-    const Dec16 cMax = spline->getCoordMax();
-    const Dec16 step = (cMax - cMin) / mResolution;
-    iPoints.reserve(mResolution);
-    for (Dec16 ci = cMin; ci <= cMax; ci += step) {
-        // get point in user coordinates with user spline
-        const auto [x, y] = spline->value(ci);
-        const Point userPoint(
-            mUserCoords.clampX(x),
-            mUserCoords.clampY(y)
-        );
-        // transform point to window coordinates
-        const WindowPoint p = mPointTransformer.userToWindow(userPoint);
-        iPoints.push_back(p);
-    }
-    return iPoints;
+// true if the displayed spline was fitted for the current points and settings
+bool App::isSplineUpToDate() const {
+    return mSplineResult != nullptr
+           && mSplineResult->generation == mFrameContext.splineGeneration
+           && !mFrameContext.isSplineDirty
+           && !mFrameContext.isUserModifiedPoints;
 }
 
 bool App::isParametric(const SplineType splineType) {
@@ -424,23 +585,20 @@ void App::updateDragLocation(const int dragIdx) {
         }
     }
 
+    if (newDragPoint.x == dragPoint.x && newDragPoint.y == dragPoint.y) {
+        // the point has not moved, keep the spline
+        return;
+    }
+
     // update point
-    modifyPoints([this, dragIdx, newDragPoint] {
+    modifyPoints([this, dragIdx, dragPoint, newDragPoint] {
         mWindowPoints[dragIdx] = newDragPoint;
+        mKnotIndex.onMove(mWindowPoints, dragIdx, dragPoint);
     });
 }
 
 int App::findPointUnderCursor(const sf::Vector2i mousePos) const {
-    using namespace sf;
-
-    int result = -1;
-    for (int i = 0; i < mWindowPoints.size(); i++) {
-        if (mWindowPoints[i].isInBounds(mousePos.x, mousePos.y, mPointSize)) {
-            result = i;
-            break;
-        }
-    }
-    return result;
+    return mKnotIndex.find(mWindowPoints, mousePos.x, mousePos.y, mPointSize);
 }
 
 // returns click position and the knot index after which the click occurred
@@ -478,6 +636,10 @@ std::pair<WindowPoint, int> App::findSplineClicked(const TV::Math::SplineFunctio
 }
 
 void App::tryInsertPoint(const TV::Math::SplineFunction* spline, const sf::Vector2i mousePos) {
+    if (!isSplineUpToDate()) {
+        // knot indices of an outdated spline do not match the points
+        return;
+    }
     // check if click is on the spline
     std::pair<WindowPoint, int> result = findSplineClicked(spline, mousePos, mPointSize);
     if (result.second != -1) {
@@ -490,6 +652,7 @@ void App::tryInsertPoint(const TV::Math::SplineFunction* spline, const sf::Vecto
             // insert new point
             modifyPoints([this, knotIndex, clickLocation] {
                 mWindowPoints.insert(mWindowPoints.begin() + knotIndex, clickLocation);
+                mKnotIndex.onInsert(mWindowPoints, knotIndex);
             });
             // start drag
             mFrameContext.dragPointIdx = result.second;
@@ -500,7 +663,11 @@ void App::tryInsertPoint(const TV::Math::SplineFunction* spline, const sf::Vecto
 void App::removePoint(const int idx) {
     if (mWindowPoints.size() > 2) {
         if (isParametric(mSplineType) || (idx != mWindowPoints.size() - 1 && idx != 0)) {
-            modifyPoints([this, idx] { mWindowPoints.erase(mWindowPoints.begin() + idx); });
+            modifyPoints([this, idx] {
+                const WindowPoint erased = mWindowPoints[idx];
+                mWindowPoints.erase(mWindowPoints.begin() + idx);
+                mKnotIndex.onErase(mWindowPoints, idx, erased);
+            });
         }
     }
 }
@@ -516,10 +683,11 @@ void App::setPoints(const std::vector<Point>& newPoints) {
                    [this](const Point p) {
                        return mPointTransformer.userToWindow(p);
                    });
+    mKnotIndex.rebuild(mWindowPoints, isParametric(mSplineType));
     mFrameContext.isUserModifiedPoints = true;
 }
 
-std::vector<Point> App::getUserPoints() {
+const std::vector<Point>& App::getUserPoints() {
     std::vector<Point>& userPoints = mFrameContext.userPoints;
     if (mFrameContext.isUserModifiedPoints) {
         userPoints.resize(mWindowPoints.size());
@@ -528,6 +696,12 @@ std::vector<Point> App::getUserPoints() {
                            return mPointTransformer.windowToUser(p);
                        });
         mFrameContext.isUserModifiedPoints = false;
+        onUserPointsChanged();
     }
     return userPoints;
 }
+
+void App::onUserPointsChanged() {
+    mFrameContext.isSplineDirty = true;
+    mFrameContext.isPointsTextDirty = true;
+}
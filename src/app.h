@@ -1,33 +1,43 @@
 #pragma once
+#include <memory>
+#include <optional>
+
 #include "boundsRect.h"
 #include "drawer.h"
+#include "knotIndex.h"
+#include "pointParser.h"
 #include "pointTransformer.h"
-#include "../libs/tv/tvmath.h"
+#include "splineWorker.h"
+#include "../libs/tv/spline.h"
 #include "SFML/System/Clock.hpp"
 #include "SFML/System/Vector2.hpp"
-
-class TextContainer;
+#include "SFML/Window/Event.hpp"
 
 namespace sf {
-    class Event;
     class RenderWindow;
 }
 
 struct WindowPoint;
 
-enum SplineType {
-    Linear,
-    Cubic,
-    CubicMonotone,
-    Parametric
-};
-
 // data that is not a part of state, but has to be shared between loop cycles
 struct FrameContext {
     sf::Clock deltaClock;
     int dragPointIdx = -1;
     bool isUserModifiedPoints = false;
+    // user points were recalculated, spline has to be fitted again
+    bool isSplineDirty = true;
+    // settings and generation of the last submitted fit request
+    SplineSettings splineSettings{};
+    int splineGeneration = 0;
     std::vector<Point> userPoints;
+    // cached text of userPoints and the value mode it was built with
+    std::pair<std::string, std::string> pointsText;
+    bool isPointsTextDirty = true;
+    bool isPointsTextRaw = false;
+    // frames left to render before on-demand mode goes idle
+    int pendingFrames = 0;
+    // event that woke the loop up from waiting
+    std::optional<sf::Event> wakeEvent;
 };
 
 class App {
@@ -37,9 +47,18 @@ public:
     void run();
 
 private:
-    [[nodiscard]] TV::Math::SplineFunction* generateSpline(const std::vector<Point>& points) const;
+    // frames rendered after the last input, GUI needs a few to settle hover and layout
+    static constexpr int REDRAW_FRAMES = 3;
+    // visible rows of the points table
+    static constexpr int POINTS_TABLE_ROWS = 8;
+
+    [[nodiscard]] bool isRedrawRequired() const;
+
+    void waitForRedraw();
 
-    std::vector<WindowPoint> generateIntermediatePoints(const TV::Math::SplineFunction* spline) const;
+    void updateSpline(const std::vector<Point>& userKnots);
+
+    [[nodiscard]] bool isSplineUpToDate() const;
 
     static bool isParametric(SplineType splineType);
 
@@ -60,7 +79,10 @@ private:
 
     void setPoints(const std::vector<Point>& newPoints);
 
-    std::vector<Point> getUserPoints();
+    const std::vector<Point>& getUserPoints();
+
+    // invalidates everything derived from userPoints, every writer of userPoints has to call it
+    void onUserPointsChanged();
 
     void initialPointsState();
 
@@ -68,15 +90,21 @@ private:
 
     void drawGuiWidgets();
 
-    std::pair<std::string, std::string> captureCurrentPoints();
+    void drawProfilerOverlay() const;
+
+    // table of user points, formats only visible rows
+    void drawPointsTable() const;
 
-    static void writeToContainer(TextContainer& container,
-                                 const std::string& xFormat, const std::string& xString,
-                                 const std::string& yFormat, const std::string& yString);
+    // comma separated x and y lists of user points, rebuilt only after points or value mode change
+    const std::pair<std::string, std::string>& getPointsText();
+
+    // writes the current spline as a self-contained C++ header
+    [[nodiscard]] bool exportSplineHeader(const std::string& path) const;
 
     void refreshCoordinateSystem();
 
-    std::vector<Point> parsePoints(const std::string& xStr, const std::string& yStr) const;
+    // applies parsed points or stores the parse error
+    void loadPoints(SplGen::PointParseResult result, std::string& error);
 
     void updateMouseTooltip(int hoveringPoint, const std::vector<Point>& userKnots) const;
 
@@ -95,6 +123,9 @@ private:
     int mResolution = 100;
     SplineType mSplineType = CubicMonotone;
     bool mIsRawValues = false;
+    bool mIsShowProfiler = false;
+    // render only on input instead of continuous loop
+    bool mIsOnDemandRendering = true;
 
     // app has 3 coordinate systems: user defined coords, screen coords and spline internal (normalized) coords
     BoundsRect<TV::Math::Dec16> mUserCoords;
@@ -102,6 +133,13 @@ private:
     PointTransformer mPointTransformer;
 
     std::vector<WindowPoint> mWindowPoints;
+    // lookup of knots under cursor, has to be notified about every change of mWindowPoints
+    KnotIndex mKnotIndex;
+
+    // fits splines in background, refit is requested only when points or spline settings change
+    SplineWorker mSplineWorker;
+    // latest fitted spline and its samples, owned by the worker
+    const SplineResult* mSplineResult = nullptr;
 
     sf::RenderWindow& mWindow;
     Drawer mDrawer;
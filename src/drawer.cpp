@@ -1,78 +1,216 @@
 #include "drawer.h"
 #include "tv/spline.h"
 #include "point.h"
+#include "tv/profiler.h"
 
+#include <cmath>
+#include <numbers>
 #include <SFML/Graphics.hpp>
 
 Drawer::Drawer(sf::RenderWindow& window)
-    : mWindow(window) {
+    : mWindow(window),
+      mRefLines(sf::PrimitiveType::LineStrip, sf::VertexBuffer::Usage::Dynamic),
+      mCurve(sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Stream),
+      mKnotCircles(sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Dynamic),
+      mConPointCircles(sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Stream) {
 }
 
-void Drawer::draw(const std::vector<WindowPoint>& knotPoints,
-                  const std::vector<WindowPoint>& intermediatePoints) const {
+void Drawer::setKnots(const std::vector<WindowPoint>& knotPoints) {
+    mKnots = knotPoints;
+    rebuildKnots();
+}
+
+void Drawer::setCurve(const CurveSamples& curveSamples) {
+    mCurveSamples = curveSamples;
+    rebuildCurve();
+}
+
+void Drawer::rebuildKnots() {
+    using namespace sf;
+
+    std::vector<Vertex> vertices;
+    vertices.reserve(mKnots.size());
+    for (auto [x, y]: mKnots) {
+        vertices.push_back(Vertex{Vector2f(x, y)});
+    }
+    mRefLines.update(vertices);
+
+    vertices.clear();
+    appendCircles(vertices, mKnots, mPointSize, Color(0xdd1d1dff));
+    mKnotCircles.update(vertices);
+}
+
+void Drawer::rebuildCurve() {
+    using namespace sf;
+
+    std::vector<Vertex> vertices;
+    SplGen::extrudePolyline(mCurveSamples, mLineThickness, Color(0xa1d7feff), vertices);
+    mCurve.update(vertices);
+
+    vertices.clear();
+    appendCircles(vertices, mCurveSamples.points, mConPointSize, Color(0xf55df2ff));
+    mConPointCircles.update(vertices);
+}
+
+void Drawer::appendCircles(std::vector<sf::Vertex>& vertices, const std::vector<WindowPoint>& centers,
+                           const int radius, const sf::Color color) {
+    using namespace sf;
+
+    if (radius <= 0) {
+        return;
+    }
+
+    // small circles do not need as many segments as large ones
+    const int segments = std::clamp(radius * 4, 8, 30);
+    std::vector<Vector2f> unitCircle(segments + 1);
+    for (int i = 0; i <= segments; i++) {
+        const float angle = 2.f * std::numbers::pi_v<float> * i / segments;
+        unitCircle[i] = Vector2f(std::cos(angle) * radius, std::sin(angle) * radius);
+    }
+
+    vertices.reserve(vertices.size() + centers.size() * segments * 3);
+    for (auto [x, y]: centers) {
+        const Vector2f center(x, y);
+        for (int i = 0; i < segments; i++) {
+            vertices.push_back(Vertex{center, color});
+            vertices.push_back(Vertex{center + unitCircle[i], color});
+            vertices.push_back(Vertex{center + unitCircle[i + 1], color});
+        }
+    }
+}
+
+void Drawer::draw() {
     using namespace TV::Math;
     using namespace sf;
+    TV_PROFILE_ZONE("Drawer::draw");
+
+    mStats = DrawStats{};
 
     // fill background
     mWindow.clear(Color(0x1f1f1fff));
 
     // Draw grid
-    drawGridBackground(100, 100, Color(0x323232ff));
+    drawGridBackground(mGrid, 100, 100, Color(0x323232ff));
 
     // draw reference lines
     if (mIsDrawRefLines) {
-        VertexArray refLines(PrimitiveType::LineStrip);
-        for (auto [x, y]: knotPoints) {
-            refLines.append(Vertex(Vector2f(x, y)));
-        }
-        mWindow.draw(refLines);
+        submit(mRefLines);
     }
 
     // draw lines
-    VertexArray lines(PrimitiveType::LineStrip);
-    for (auto c: intermediatePoints) {
-        lines.append(Vertex(Vector2f(c.x, c.y), Color(0xa1d7feff)));
-    }
-    mWindow.draw(lines);
+    submit(mCurve);
 
     // draw connection points
-    for (auto [x, y]: intermediatePoints) {
-        CircleShape point(mConPointSize);
-        point.setFillColor(Color(0xf55df2ff));
-        point.setOrigin(Vector2f(mConPointSize, mConPointSize));
-        point.setPosition(Vector2f(x, y));
-        mWindow.draw(point);
-    }
+    submit(mConPointCircles);
 
     // draw points
-    for (auto [x, y]: knotPoints) {
-        CircleShape point(mPointSize);
-        point.setFillColor(Color(0xdd1d1dff));
-        point.setOrigin(Vector2f(mPointSize, mPointSize));
-        point.setPosition(Vector2f(x, y));
-        mWindow.draw(point);
+    submit(mKnotCircles);
+}
+
+void Drawer::drawGridBackground(GridLayer& layer, const int cellWidth, const int cellHeight, const sf::Color color) {
+    using namespace sf;
+
+    const Vector2u windowSize = mWindow.getSize();
+    const bool isChanged = layer.cellWidth != cellWidth || layer.cellHeight != cellHeight
+                           || layer.color != color || layer.windowSize != windowSize;
+    if (isChanged) {
+        layer.cellWidth = cellWidth;
+        layer.cellHeight = cellHeight;
+        layer.color = color;
+        layer.windowSize = windowSize;
+
+        const int rowsNum = windowSize.x / cellWidth;
+        const int colsNum = windowSize.y / cellHeight;
+        std::vector<Vertex> vertices;
+        vertices.reserve((rowsNum + colsNum + 2) * 6);
+
+        // horizontal lines
+        for (int i = 0; i <= rowsNum; ++i) {
+            appendRect(vertices, Vector2f(0, i * cellWidth), Vector2f(rowsNum * cellWidth, 1), color);
+        }
+
+        // vertical lines
+        for (int i = 0; i <= colsNum; ++i) {
+            appendRect(vertices, Vector2f(i * cellHeight, 0), Vector2f(1, colsNum * cellHeight), color);
+        }
+        layer.lines.update(vertices);
     }
+
+    submit(layer.lines);
 }
 
-void Drawer::drawGridBackground(const int cellWidth, const int cellHeight, const sf::Color color) const {
+void Drawer::appendRect(std::vector<sf::Vertex>& vertices, const sf::Vector2f pos, const sf::Vector2f size,
+                        const sf::Color color) {
     using namespace sf;
 
-    const int rowsNum = mWindow.getSize().x / cellWidth;
-    const int colsNum = mWindow.getSize().y / cellHeight;
+    const Vector2f topRight = pos + Vector2f(size.x, 0);
+    const Vector2f bottomLeft = pos + Vector2f(0, size.y);
+    const Vector2f bottomRight = pos + size;
+    vertices.push_back(Vertex{pos, color});
+    vertices.push_back(Vertex{topRight, color});
+    vertices.push_back(Vertex{bottomLeft, color});
+    vertices.push_back(Vertex{bottomLeft, color});
+    vertices.push_back(Vertex{topRight, color});
+    vertices.push_back(Vertex{bottomRight, color});
+}
 
-    // Draw horizontal lines
-    for (int i = 0; i <= rowsNum; ++i) {
-        RectangleShape line(Vector2f(rowsNum * cellWidth, 1));
-        line.setPosition(Vector2f(0, i * cellWidth));
-        line.setFillColor(color);
-        mWindow.draw(line);
+void Drawer::submit(const CachedBuffer& cachedBuffer) {
+    const std::vector<sf::Vertex>& vertices = cachedBuffer.vertices;
+    if (vertices.empty()) {
+        return;
     }
 
-    // Draw vertical lines
-    for (int i = 0; i <= colsNum; ++i) {
-        RectangleShape line(Vector2f(1, colsNum * cellHeight));
-        line.setPosition(Vector2f(i * cellHeight, 0));
-        line.setFillColor(color);
-        mWindow.draw(line);
+    if (sf::VertexBuffer::isAvailable()) {
+        mWindow.draw(cachedBuffer.buffer, 0, vertices.size());
+    } else {
+        // no VBO support: draw from the CPU copy
+        mWindow.draw(vertices.data(), vertices.size(), cachedBuffer.buffer.getPrimitiveType());
+    }
+    mStats.drawCalls++;
+    mStats.vertices += static_cast<int>(vertices.size());
+}
+
+Drawer::CachedBuffer::CachedBuffer(const sf::PrimitiveType type, const sf::VertexBuffer::Usage usage)
+    : buffer(type, usage) {
+}
+
+void Drawer::CachedBuffer::update(const std::vector<sf::Vertex>& newVertices) {
+    const auto isSameVertex = [](const sf::Vertex& a, const sf::Vertex& b) {
+        return a.position == b.position && a.color == b.color && a.texCoords == b.texCoords;
+    };
+
+    // find the range [first, last) that differs from what is already uploaded
+    const std::size_t commonSize = std::min(vertices.size(), newVertices.size());
+    std::size_t first = 0;
+    while (first < commonSize && isSameVertex(vertices[first], newVertices[first])) {
+        first++;
+    }
+    std::size_t last = newVertices.size();
+    if (newVertices.size() == vertices.size()) {
+        while (last > first && isSameVertex(vertices[last - 1], newVertices[last - 1])) {
+            last--;
+        }
+    }
+    vertices = newVertices;
+
+    if (!sf::VertexBuffer::isAvailable()) {
+        return;
+    }
+
+    // checked before the diff: after a failed create or update the CPU copy is ahead of the buffer
+    if (buffer.getVertexCount() < vertices.size()) {
+        // grow with reserve to not reallocate on every inserted point
+        if (!buffer.create(vertices.size() + vertices.size() / 2)) {
+            return;
+        }
+        first = 0;
+        last = vertices.size();
+    } else if (isStale) {
+        first = 0;
+        last = vertices.size();
+    }
+    if (first == last) {
+        return;
     }
+    isStale = !buffer.update(vertices.data() + first, last - first, static_cast<unsigned int>(first));
 }
@@ -2,18 +2,25 @@
 #include <vector>
 
 #include "SFML/Graphics/Color.hpp"
-
-struct WindowPoint;
+#include "SFML/Graphics/Vertex.hpp"
+#include "SFML/Graphics/VertexBuffer.hpp"
+#include "point.h"
+#include "polyline.h"
 
 namespace TV::Math {
     class SplineFunction;
 }
 
 namespace sf {
+    class Drawable;
     class RenderWindow;
 }
 
-struct Point;
+// per-frame rendering counters
+struct DrawStats {
+    int drawCalls = 0;
+    int vertices = 0;
+};
 
 class Drawer {
 public:
@@ -21,30 +28,92 @@ public:
 
     ~Drawer() = default;
 
-    void draw(const std::vector<WindowPoint>& knotPoints, const std::vector<WindowPoint>& intermediatePoints) const;
+    // geometry is kept on GPU between frames, set it only when it changes
+    void setKnots(const std::vector<WindowPoint>& knotPoints);
+
+    void setCurve(const CurveSamples& curveSamples);
+
+    void draw();
+
+    [[nodiscard]] const DrawStats& getStats() const {
+        return mStats;
+    }
 
     void setDrawRefLines(const bool isDrawRefLines) {
         mIsDrawRefLines = isDrawRefLines;
     }
 
     void setLineThickness(const int lineThickness) {
-        mLineThickness = lineThickness;
+        if (mLineThickness != lineThickness) {
+            mLineThickness = lineThickness;
+            rebuildCurve();
+        }
     }
 
     void setPointSize(const int pointSize) {
-        mPointSize = pointSize;
+        if (mPointSize != pointSize) {
+            mPointSize = pointSize;
+            rebuildKnots();
+        }
     }
 
     void setConPointSize(const int conPointSize) {
-        mConPointSize = conPointSize;
+        if (mConPointSize != conPointSize) {
+            mConPointSize = conPointSize;
+            rebuildCurve();
+        }
     }
 
 private:
+    // GPU vertex buffer with a CPU copy, which is used to find the range that has to be re-uploaded
+    struct CachedBuffer {
+        sf::VertexBuffer buffer;
+        std::vector<sf::Vertex> vertices;
+        // last upload failed, the whole buffer is uploaded next time
+        bool isStale = false;
+
+        CachedBuffer(sf::PrimitiveType type, sf::VertexBuffer::Usage usage);
+
+        void update(const std::vector<sf::Vertex>& newVertices);
+    };
+
+    // grid geometry, regenerated only when its parameters change.
+    // Zoom with several grid levels would keep one layer per level
+    struct GridLayer {
+        int cellWidth = 0;
+        int cellHeight = 0;
+        sf::Color color;
+        sf::Vector2u windowSize;
+        CachedBuffer lines{sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Static};
+    };
+
     sf::RenderWindow& mWindow;
     bool mIsDrawRefLines = false;
     int mLineThickness = 1;
     int mPointSize = 6;
     int mConPointSize = 1;
+    DrawStats mStats;
+
+    std::vector<WindowPoint> mKnots;
+    CurveSamples mCurveSamples;
+    CachedBuffer mRefLines;
+    // extruded thick curve
+    CachedBuffer mCurve;
+    // all knots and all connection points are batched in one triangle list each
+    CachedBuffer mKnotCircles;
+    CachedBuffer mConPointCircles;
+    GridLayer mGrid;
+
+    void rebuildKnots();
+
+    void rebuildCurve();
+
+    static void appendCircles(std::vector<sf::Vertex>& vertices, const std::vector<WindowPoint>& centers,
+                              int radius, sf::Color color);
+
+    void drawGridBackground(GridLayer& layer, int cellWidth, int cellHeight, sf::Color color);
+
+    static void appendRect(std::vector<sf::Vertex>& vertices, sf::Vector2f pos, sf::Vector2f size, sf::Color color);
 
-    void drawGridBackground(int cellWidth, int cellHeight, sf::Color color) const;
+    void submit(const CachedBuffer& cachedBuffer);
 };
@@ -0,0 +1,129 @@
+#include "knotIndex.h"
+
+#include <algorithm>
+
+void KnotIndex::rebuild(const std::vector<WindowPoint>& points, const bool isParametric) {
+    mCells.clear();
+    // loaded points may come in any order, non-parametric splines need them sorted anyway
+    mIsSortedByX = !isParametric && std::is_sorted(points.begin(), points.end());
+    if (!mIsSortedByX) {
+        rebuildGrid(points);
+    }
+}
+
+void KnotIndex::onInsert(const std::vector<WindowPoint>& points, const int idx) {
+    if (mIsSortedByX) {
+        if (!isSortedAround(points, idx)) {
+            rebuildGrid(points);
+        }
+        return;
+    }
+    shiftIndices(idx, 1);
+    addToCell(points[idx], idx);
+}
+
+void KnotIndex::onErase(const std::vector<WindowPoint>& points, const int idx, const WindowPoint erased) {
+    if (mIsSortedByX) {
+        // erase keeps the order
+        return;
+    }
+    removeFromCell(erased, idx);
+    shiftIndices(idx + 1, -1);
+}
+
+void KnotIndex::onMove(const std::vector<WindowPoint>& points, const int idx, const WindowPoint from) {
+    if (mIsSortedByX) {
+        if (!isSortedAround(points, idx)) {
+            rebuildGrid(points);
+        }
+        return;
+    }
+    if (cellKey(from) != cellKey(points[idx])) {
+        removeFromCell(from, idx);
+        addToCell(points[idx], idx);
+    }
+}
+
+int KnotIndex::find(const std::vector<WindowPoint>& points, const int px, const int py, const int r) const {
+    const int reach = r + WindowPoint::HIT_FALL_OFF;
+
+    if (mIsSortedByX) {
+        // only points with x in [px - reach, px + reach] can be hit
+        auto it = std::lower_bound(points.begin(), points.end(), WindowPoint(px - reach, 0));
+        for (; it != points.end() && it->x <= px + reach; ++it) {
+            if (it->isInBounds(px, py, r)) {
+                return static_cast<int>(std::distance(points.begin(), it));
+            }
+        }
+        return -1;
+    }
+
+    int result = -1;
+    for (int cx = cellCoord(px - reach); cx <= cellCoord(px + reach); cx++) {
+        for (int cy = cellCoord(py - reach); cy <= cellCoord(py + reach); cy++) {
+            const auto cell = mCells.find(cellKey(cx, cy));
+            if (cell == mCells.end()) {
+                continue;
+            }
+            for (const int idx: cell->second) {
+                if ((result == -1 || idx < result) && points[idx].isInBounds(px, py, r)) {
+                    result = idx;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+int KnotIndex::cellCoord(const int c) {
+    // floor division, points may be slightly outside the window
+    return c >= 0 ? c / CELL_SIZE : (c - CELL_SIZE + 1) / CELL_SIZE;
+}
+
+int64_t KnotIndex::cellKey(const int cx, const int cy) {
+    return static_cast<int64_t>(cx) << 32 | static_cast<uint32_t>(cy);
+}
+
+int64_t KnotIndex::cellKey(const WindowPoint p) {
+    return cellKey(cellCoord(p.x), cellCoord(p.y));
+}
+
+void KnotIndex::addToCell(const WindowPoint p, const int idx) {
+    mCells[cellKey(p)].push_back(idx);
+}
+
+void KnotIndex::removeFromCell(const WindowPoint p, const int idx) {
+    const auto cell = mCells.find(cellKey(p));
+    if (cell == mCells.end()) {
+        return;
+    }
+    std::erase(cell->second, idx);
+    if (cell->second.empty()) {
+        mCells.erase(cell);
+    }
+}
+
+void KnotIndex::shiftIndices(const int fromIdx, const int delta) {
+    // linear in knot count, but only plain integer updates and only on insert/erase
+    for (auto& [key, indices]: mCells) {
+        for (int& idx: indices) {
+            if (idx >= fromIdx) {
+                idx += delta;
+            }
+        }
+    }
+}
+
+void KnotIndex::rebuildGrid(const std::vector<WindowPoint>& points) {
+    mIsSortedByX = false;
+    mCells.clear();
+    for (int i = 0; i < points.size(); i++) {
+        addToCell(points[i], i);
+    }
+}
+
+bool KnotIndex::isSortedAround(const std::vector<WindowPoint>& points, const int idx) {
+    const bool prevOk = idx == 0 || !(points[idx] < points[idx - 1]);
+    const bool nextOk = idx + 1 >= points.size() || !(points[idx + 1] < points[idx]);
+    return prevOk && nextOk;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "point.h"
+
+// Finds the knot under cursor without scanning all knots.
+// Knots sorted by x (non-parametric splines) are found with binary search by x,
+// knots in arbitrary order (parametric splines) are put into a uniform grid.
+// The index is kept in sync incrementally by notifying it about every knot insert, erase and move.
+class KnotIndex {
+public:
+    void rebuild(const std::vector<WindowPoint>& points, bool isParametric);
+
+    // point was inserted to points at idx
+    void onInsert(const std::vector<WindowPoint>& points, int idx);
+
+    // point was erased from points at idx
+    void onErase(const std::vector<WindowPoint>& points, int idx, WindowPoint erased);
+
+    // point at idx was moved
+    void onMove(const std::vector<WindowPoint>& points, int idx, WindowPoint from);
+
+    // returns the smallest index of the point within r from (px, py) or -1
+    [[nodiscard]] int find(const std::vector<WindowPoint>& points, int px, int py, int r) const;
+
+private:
+    static constexpr int CELL_SIZE = 32;
+
+    bool mIsSortedByX = true;
+    std::unordered_map<int64_t, std::vector<int>> mCells;
+
+    static int cellCoord(int c);
+
+    static int64_t cellKey(int cx, int cy);
+
+    static int64_t cellKey(WindowPoint p);
+
+    void addToCell(WindowPoint p, int idx);
+
+    void removeFromCell(WindowPoint p, int idx);
+
+    // adds delta to all stored indices not less than fromIdx
+    void shiftIndices(int fromIdx, int delta);
+
+    void rebuildGrid(const std::vector<WindowPoint>& points);
+
+    static bool isSortedAround(const std::vector<WindowPoint>& points, int idx);
+};
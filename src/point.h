@@ -11,6 +11,9 @@ struct Point {
 };
 
 struct WindowPoint {
+    // extra distance around a point that still counts as a hit
+    static constexpr int HIT_FALL_OFF = 2;
+
     int x;
     int y;
 
@@ -52,8 +55,7 @@ struct WindowPoint {
     [[nodiscard]] constexpr bool isInBounds(const int px, const int py, const int r) const {
         const int cX = x;
         const int cY = y;
-        constexpr int fallOff = 2;
         // compare sqr-s to not count sqrt for length
-        return (r + fallOff) * (r + fallOff) > (px - cX) * (px - cX) + (py - cY) * (py - cY);
+        return (r + HIT_FALL_OFF) * (r + HIT_FALL_OFF) > (px - cX) * (px - cX) + (py - cY) * (py - cY);
     }
 };
@@ -0,0 +1,151 @@
+#include "pointParser.h"
+
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <limits>
+
+#include "tv/mappedFile.h"
+
+namespace {
+    using TV::Math::Dec16;
+
+    // integer coordinates have to fit into the integral part of Dec16
+    constexpr int MAX_INT_VALUE = std::numeric_limits<int32_t>::max() >> 16;
+    constexpr int MIN_INT_VALUE = std::numeric_limits<int32_t>::min() >> 16;
+
+    bool isBlank(const char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    const char* skipBlank(const char* p, const char* end) {
+        while (p != end && isBlank(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    // number of values in the list, delimiters are found with memchr which is vectorized by the C library
+    std::size_t countValues(const char* begin, const char* end) {
+        if (skipBlank(begin, end) == end) {
+            return 0;
+        }
+        std::size_t count = 1;
+        const char* p = begin;
+        while ((p = static_cast<const char*>(std::memchr(p, ',', end - p))) != nullptr) {
+            count++;
+            p++;
+        }
+        return count;
+    }
+
+    struct AxisList {
+        const char* name;
+        const char* begin;
+        const char* end;
+        // offset of begin in the whole parsed text, for error positions
+        std::ptrdiff_t offset;
+    };
+
+    void setError(SplGen::PointParseResult& result, const AxisList& list, const char* p, const char* what) {
+        result.errorPos = list.offset + (p - list.begin);
+        result.error = std::format("{}: {} at {}", list.name, what, result.errorPos);
+        result.points.clear();
+    }
+
+    // parses the list straight into the given coordinate of already sized points
+    bool parseAxis(const AxisList& list, const bool isRaw, Dec16 Point::* axis, SplGen::PointParseResult& result) {
+        const char* p = list.begin;
+        for (Point& point: result.points) {
+            p = skipBlank(p, list.end);
+            int value = 0;
+            const auto [next, ec] = std::from_chars(p, list.end, value);
+            if (ec == std::errc::invalid_argument) {
+                setError(result, list, p, "number expected");
+                return false;
+            }
+            if (ec == std::errc::result_out_of_range || (!isRaw && (value < MIN_INT_VALUE || value > MAX_INT_VALUE))) {
+                setError(result, list, p, "value out of range");
+                return false;
+            }
+            point.*axis = isRaw ? Dec16::from_raw_value(value) : Dec16{value};
+
+            p = skipBlank(next, list.end);
+            if (p != list.end) {
+                // number of values equals number of commas plus one, so only the last value ends the list
+                if (*p != ',') {
+                    setError(result, list, p, "',' expected");
+                    return false;
+                }
+                p++;
+            }
+        }
+        return true;
+    }
+
+    SplGen::PointParseResult parseLists(const AxisList& xList, const AxisList& yList, const bool isRaw) {
+        SplGen::PointParseResult result;
+        const std::size_t xCount = countValues(xList.begin, xList.end);
+        const std::size_t yCount = countValues(yList.begin, yList.end);
+        if (xCount != yCount) {
+            result.error = std::format("X has {} values, Y has {}", xCount, yCount);
+            return result;
+        }
+        if (xCount < SplGen::MIN_PARSED_POINTS) {
+            result.error = std::format("at least {} points required", SplGen::MIN_PARSED_POINTS);
+            return result;
+        }
+
+        result.points.resize(xCount);
+        if (parseAxis(xList, isRaw, &Point::x, result)) {
+            parseAxis(yList, isRaw, &Point::y, result);
+        }
+        return result;
+    }
+}
+
+namespace SplGen {
+    PointParseResult parsePoints(const std::string_view xStr, const std::string_view yStr, const bool isRaw) {
+        return parseLists(AxisList{"X", xStr.data(), xStr.data() + xStr.size(), 0},
+                          AxisList{"Y", yStr.data(), yStr.data() + yStr.size(), 0}, isRaw);
+    }
+
+    PointParseResult parsePointsFile(const std::filesystem::path& path, const bool isRaw) {
+        PointParseResult result;
+        TV::MappedFile file;
+        if (!file.open(path, TV::MappedFile::Mode::Read)) {
+            result.error = std::format("can't open {}", path.string());
+            return result;
+        }
+        if (file.getSize() == 0) {
+            result.error = "file is empty";
+            return result;
+        }
+        const auto* text = reinterpret_cast<const char*>(file.map(0, file.getSize()));
+        if (text == nullptr) {
+            result.error = std::format("can't map {}", path.string());
+            return result;
+        }
+
+        const char* end = text + file.getSize();
+        const auto* xEnd = static_cast<const char*>(std::memchr(text, '\n', end - text));
+        if (xEnd == nullptr) {
+            result.error = "second line with Y values expected";
+            result.errorPos = end - text;
+            return result;
+        }
+        const char* yBegin = xEnd + 1;
+        const auto* yEnd = static_cast<const char*>(std::memchr(yBegin, '\n', end - yBegin));
+        if (yEnd == nullptr) {
+            yEnd = end;
+        }
+        if (const char* rest = skipBlank(yEnd, end); rest != end) {
+            result.errorPos = rest - text;
+            result.error = std::format("unexpected data after Y values at {}", result.errorPos);
+            return result;
+        }
+
+        return parseLists(AxisList{"X", text, xEnd, 0},
+                          AxisList{"Y", yBegin, yEnd, yBegin - text}, isRaw);
+    }
+}
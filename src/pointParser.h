@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "point.h"
+
+namespace SplGen {
+    // fewer points can't make a spline, the app never goes below this count either
+    inline constexpr std::size_t MIN_PARSED_POINTS = 2;
+
+    struct PointParseResult {
+        std::vector<Point> points;
+        // empty on success
+        std::string error;
+        // byte offset of the error in the parsed text, -1 if the error has no position
+        std::ptrdiff_t errorPos = -1;
+
+        [[nodiscard]] bool isOk() const {
+            return error.empty();
+        }
+    };
+
+    // Parses comma separated integer lists of x and y coordinates into points.
+    // Values are Dec16 raw values if isRaw is set, integer coordinates otherwise.
+    // Spaces around values are allowed. Parsing is a single pass over each list and
+    // the only allocation is the result, so it handles lists of millions of values.
+    PointParseResult parsePoints(std::string_view xStr, std::string_view yStr, bool isRaw);
+
+    // Parses a file with the x list on the first line and the y list on the second,
+    // the same layout as the text copied from the app. Error position is an offset in the file.
+    PointParseResult parsePointsFile(const std::filesystem::path& path, bool isRaw);
+}
@@ -0,0 +1,144 @@
+#include "polyline.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SplGen {
+    namespace {
+        // width of the anti-aliasing alpha ramp
+        constexpr float FEATHER = 1.f;
+        // max ratio of join offset to half-width before switching to bevel
+        constexpr float MITER_LIMIT = 2.f;
+
+        // quad [a, b] - [c, d] as two triangles
+        void appendQuad(std::vector<sf::Vertex>& vertices,
+                        const sf::Vector2f a, const sf::Vector2f b, const sf::Color abColor,
+                        const sf::Vector2f c, const sf::Vector2f d, const sf::Color cdColor) {
+            vertices.push_back(sf::Vertex{a, abColor});
+            vertices.push_back(sf::Vertex{b, abColor});
+            vertices.push_back(sf::Vertex{c, cdColor});
+            vertices.push_back(sf::Vertex{c, cdColor});
+            vertices.push_back(sf::Vertex{b, abColor});
+            vertices.push_back(sf::Vertex{d, cdColor});
+        }
+    }
+
+    void extrudePolyline(const CurveSamples& samples, const float thickness, const sf::Color color,
+                         std::vector<sf::Vertex>& vertices) {
+        const std::vector<WindowPoint>& points = samples.points;
+        const bool hasTangents = samples.tangents.size() == points.size();
+
+        // structure of arrays, so the passes below are plain loops over floats.
+        // Window points are integral and neighbour samples often coincide: drop repeats
+        std::vector<float> px;
+        std::vector<float> py;
+        std::vector<float> tx;
+        std::vector<float> ty;
+        px.reserve(points.size());
+        py.reserve(points.size());
+        tx.reserve(points.size());
+        ty.reserve(points.size());
+        for (int i = 0; i < points.size(); i++) {
+            if (i > 0 && points[i].x == points[i - 1].x && points[i].y == points[i - 1].y) {
+                continue;
+            }
+            px.push_back(points[i].x);
+            py.push_back(points[i].y);
+            tx.push_back(hasTangents ? samples.tangents[i].x : 0.f);
+            ty.push_back(hasTangents ? samples.tangents[i].y : 0.f);
+        }
+
+        const int n = px.size();
+        if (n < 2) {
+            return;
+        }
+
+        // unit normals of segments
+        std::vector<float> nx(n - 1);
+        std::vector<float> ny(n - 1);
+        for (int i = 0; i < n - 1; i++) {
+            const float dx = px[i + 1] - px[i];
+            const float dy = py[i + 1] - py[i];
+            const float invLength = 1.f / std::sqrt(dx * dx + dy * dy);
+            nx[i] = -dy * invLength;
+            ny[i] = dx * invLength;
+        }
+
+        // join offset per point: unit direction and the multiplier keeping both adjacent segments
+        // at full width. Zero multiplier marks a bevel join
+        std::vector<float> jx(n);
+        std::vector<float> jy(n);
+        std::vector<float> js(n);
+        for (int i = 0; i < n; i++) {
+            const int prev = std::max(i - 1, 0);
+            const int next = std::min(i, n - 2);
+
+            // miter from neighbour segments
+            float dx = nx[prev] + nx[next];
+            float dy = ny[prev] + ny[next];
+            const float miterLength = std::sqrt(dx * dx + dy * dy);
+            if (miterLength > 1e-3f) {
+                dx /= miterLength;
+                dy /= miterLength;
+            } else {
+                // U-turn
+                dx = nx[prev];
+                dy = ny[prev];
+            }
+
+            // normal from spline derivative, oriented to the same side as the miter
+            const float tangentLength = std::sqrt(tx[i] * tx[i] + ty[i] * ty[i]);
+            if (tangentLength > 0.f) {
+                const float sign = -ty[i] * dx + tx[i] * dy < 0.f ? -1.f : 1.f;
+                dx = -ty[i] / tangentLength * sign;
+                dy = tx[i] / tangentLength * sign;
+            }
+
+            const float cosMin = std::min(dx * nx[prev] + dy * ny[prev], dx * nx[next] + dy * ny[next]);
+            jx[i] = dx;
+            jy[i] = dy;
+            js[i] = cosMin > 1.f / MITER_LIMIT ? 1.f / cosMin : 0.f;
+        }
+
+        const float halfWidth = std::max(thickness, 1.f) / 2.f;
+        const float outerWidth = halfWidth + FEATHER;
+        const sf::Color clear(color.r, color.g, color.b, 0);
+        vertices.reserve(vertices.size() + (n - 1) * 18);
+
+        // segments: core band and a feather band on each side
+        for (int i = 0; i < n - 1; i++) {
+            const sf::Vector2f p0(px[i], py[i]);
+            const sf::Vector2f p1(px[i + 1], py[i + 1]);
+            const sf::Vector2f o0 = js[i] > 0.f
+                                        ? sf::Vector2f(jx[i] * js[i], jy[i] * js[i])
+                                        : sf::Vector2f(nx[i], ny[i]);
+            const sf::Vector2f o1 = js[i + 1] > 0.f
+                                        ? sf::Vector2f(jx[i + 1] * js[i + 1], jy[i + 1] * js[i + 1])
+                                        : sf::Vector2f(nx[i], ny[i]);
+
+            appendQuad(vertices, p0 + o0 * halfWidth, p1 + o1 * halfWidth, color,
+                       p0 - o0 * halfWidth, p1 - o1 * halfWidth, color);
+            appendQuad(vertices, p0 + o0 * halfWidth, p1 + o1 * halfWidth, color,
+                       p0 + o0 * outerWidth, p1 + o1 * outerWidth, clear);
+            appendQuad(vertices, p0 - o0 * halfWidth, p1 - o1 * halfWidth, color,
+                       p0 - o0 * outerWidth, p1 - o1 * outerWidth, clear);
+        }
+
+        // bevels fill the gap between segment ends at sharp joins, on both sides
+        for (int i = 1; i < n - 1; i++) {
+            if (js[i] > 0.f) {
+                continue;
+            }
+            const sf::Vector2f p(px[i], py[i]);
+            for (const float side: {1.f, -1.f}) {
+                const sf::Vector2f nPrev(nx[i - 1] * side, ny[i - 1] * side);
+                const sf::Vector2f nNext(nx[i] * side, ny[i] * side);
+                vertices.push_back(sf::Vertex{p, color});
+                vertices.push_back(sf::Vertex{p + nPrev * halfWidth, color});
+                vertices.push_back(sf::Vertex{p + nNext * halfWidth, color});
+                appendQuad(vertices, p + nPrev * halfWidth, p + nNext * halfWidth, color,
+                           p + nPrev * outerWidth, p + nNext * outerWidth, clear);
+            }
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+
+#include "point.h"
+#include "SFML/Graphics/Color.hpp"
+#include "SFML/Graphics/Vertex.hpp"
+#include "SFML/System/Vector2.hpp"
+
+// sampled curve in window coordinates
+struct CurveSamples {
+    std::vector<WindowPoint> points;
+    // tangent directions from spline derivatives, not normalized. Zero length if unknown
+    std::vector<sf::Vector2f> tangents;
+};
+
+namespace SplGen {
+    /**
+     * Turns a polyline into a triangle list of given thickness with anti-aliased edges:
+     * opaque core and 1px wide alpha feather on both sides.
+     * Joins are mitered along the tangent if given or along neighbour segments otherwise,
+     * too sharp joins fall back to bevel.
+     *
+     * @param samples polyline points with optional tangents
+     * @param thickness line width in pixels
+     * @param color line color
+     * @param vertices output triangle list, appended
+     */
+    void extrudePolyline(const CurveSamples& samples, float thickness, sf::Color color,
+                         std::vector<sf::Vertex>& vertices);
+}
@@ -0,0 +1,147 @@
+#include "splineWorker.h"
+
+#include <algorithm>
+#include <optional>
+
+#include "pointTransformer.h"
+#include "tv/profiler.h"
+
+SplineWorker::SplineWorker()
+    : mThread(&SplineWorker::loop, this) {
+}
+
+SplineWorker::~SplineWorker() {
+    mIsRunning = false;
+    mSubmitCount++;
+    mSubmitCount.notify_one();
+    mIsFresh = false;
+    mIsFresh.notify_one();
+    mThread.join();
+}
+
+bool SplineWorker::submit(SplineRequest&& request) {
+    if (!mRequests.push(std::move(request))) {
+        return false;
+    }
+    mSubmitCount.fetch_add(1, std::memory_order_release);
+    mSubmitCount.notify_one();
+    return true;
+}
+
+const SplineResult* SplineWorker::acquire() {
+    if (!mIsFresh.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    const SplineResult* result = &mResults[mFront.load(std::memory_order_acquire)];
+    // previous front is not used by UI anymore, worker may overwrite it
+    mIsFresh.store(false, std::memory_order_release);
+    mIsFresh.notify_one();
+    return result;
+}
+
+void SplineWorker::loop() {
+    while (mIsRunning) {
+        // back slot is free only after UI acquired the last published result
+        mIsFresh.wait(true, std::memory_order_acquire);
+        // destructor wakes the worker from either wait, it must not go to sleep again
+        if (!mIsRunning) {
+            return;
+        }
+
+        const int submitCount = mSubmitCount.load(std::memory_order_acquire);
+        // stale requests are dropped: only the newest one matters
+        std::optional<SplineRequest> request;
+        while (std::optional<SplineRequest> next = mRequests.pop()) {
+            request = std::move(next);
+        }
+        if (!request.has_value()) {
+            // shutdown is flagged before the count is bumped, so a count loaded after the bump sees it
+            if (!mIsRunning) {
+                return;
+            }
+            mSubmitCount.wait(submitCount, std::memory_order_acquire);
+            continue;
+        }
+
+        const int back = 1 - mFront.load(std::memory_order_relaxed);
+        SplineResult& result = mResults[back];
+        result.spline = generateSpline(request.value());
+        result.samples = generateSamples(result.spline.get(), request.value());
+        result.generation = request->generation;
+
+        mFront.store(back, std::memory_order_release);
+        mIsFresh.store(true, std::memory_order_release);
+    }
+}
+
+std::unique_ptr<TV::Math::SplineFunction> SplineWorker::generateSpline(const SplineRequest& request) {
+    using namespace TV::Math;
+    TV_PROFILE_ZONE("SplineWorker::generateSpline");
+
+    const std::vector<Point>& points = request.userPoints;
+    // transform point array to x/y arrays
+    std::vector<Dec16> x(points.size());
+    std::vector<Dec16> y(points.size());
+    std::transform(points.begin(), points.end(), x.begin(),
+                   [](const Point p) { return p.x; });
+    std::transform(points.begin(), points.end(), y.begin(),
+                   [](const Point p) { return p.y; });
+
+    const Dec16 scale{request.settings.scale};
+    const Interpolator interpolator(x, y, scale, scale);
+
+    switch (request.settings.splineType) {
+        case Cubic:
+            return std::make_unique<PolynomialSplineFunction>(interpolator.interpolateNatural());
+        case CubicMonotone:
+            return std::make_unique<PolynomialSplineFunction>(interpolator.interpolateAkima());
+        case Parametric:
+            return std::make_unique<Parametric2DPolynomialSplineFunction>(interpolator.interpolate2D());
+        case Linear:
+        default:
+            return std::make_unique<PolynomialSplineFunction>(interpolator.interpolateLinear());
+    }
+}
+
+CurveSamples SplineWorker::generateSamples(const TV::Math::SplineFunction* spline, const SplineRequest& request) {
+    using namespace TV::Math;
+    TV_PROFILE_ZONE("SplineWorker::generateSamples");
+
+    const BoundsRect<Dec16>& userCoords = request.userCoords;
+    const BoundsRect<Dec16>& windowCoords = request.windowCoords;
+    const PointTransformer pointTransformer(userCoords, windowCoords);
+    const int resolution = request.settings.resolution;
+
+    // user to window scale for tangents, y axis is flipped on the screen
+    const float xToWindow = static_cast<float>(windowCoords.xMax - windowCoords.xMin)
+                            / static_cast<float>(userCoords.xMax - userCoords.xMin);
+    const float yToWindow = -static_cast<float>(windowCoords.yMax - windowCoords.yMin)
+                            / static_cast<float>(userCoords.yMax - userCoords.yMin);
+
+    CurveSamples samples;
+    const Dec16 cMin = spline->getCoordMin();
+    const Dec16 cMax = spline->getCoordMax();
+    const Dec16 step = (cMax - cMin) / resolution;
+    samples.points.reserve(resolution + 1);
+    samples.tangents.reserve(resolution + 1);
+    for (Dec16 ci = cMin; ci <= cMax; ci += step) {
+        // get point in user coordinates with user spline
+        const auto [x, y] = spline->value(ci);
+        const Point userPoint(
+            userCoords.clampX(x),
+            userCoords.clampY(y)
+        );
+        // transform point to window coordinates
+        const WindowPoint p = pointTransformer.userToWindow(userPoint);
+        samples.points.push_back(p);
+
+        // clamped points lie on the border, the spline tangent does not describe them
+        if (userPoint.x == x && userPoint.y == y) {
+            const auto [tx, ty] = spline->tangent(ci);
+            samples.tangents.emplace_back(static_cast<float>(tx) * xToWindow, static_cast<float>(ty) * yToWindow);
+        } else {
+            samples.tangents.emplace_back(0.f, 0.f);
+        }
+    }
+    return samples;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "boundsRect.h"
+#include "point.h"
+#include "polyline.h"
+#include "spscQueue.h"
+#include "../libs/tv/spline.h"
+
+enum SplineType {
+    Linear,
+    Cubic,
+    CubicMonotone,
+    Parametric
+};
+
+// settings the fitted spline depends on
+struct SplineSettings {
+    SplineType splineType;
+    int scale;
+    int resolution;
+
+    bool operator==(const SplineSettings& other) const = default;
+};
+
+// snapshot of everything needed to fit and sample a spline
+struct SplineRequest {
+    int generation = -1;
+    std::vector<Point> userPoints;
+    SplineSettings settings{};
+    BoundsRect<TV::Math::Dec16> userCoords{};
+    BoundsRect<TV::Math::Dec16> windowCoords{};
+};
+
+struct SplineResult {
+    // generation of the request this result was computed for
+    int generation = -1;
+    std::unique_ptr<TV::Math::SplineFunction> spline;
+    CurveSamples samples;
+};
+
+// Fits and samples splines on a background thread.
+// Requests come through a lock-free queue, of all queued requests only the newest one is computed.
+// Results are double-buffered: worker fills the back slot while UI reads the front one
+// and the slots are swapped atomically on publish.
+class SplineWorker {
+public:
+    SplineWorker();
+
+    ~SplineWorker();
+
+    SplineWorker(const SplineWorker&) = delete;
+
+    SplineWorker& operator=(const SplineWorker&) = delete;
+
+    // returns false if the queue is full, the request has to be resubmitted later
+    bool submit(SplineRequest&& request);
+
+    // Returns the latest completed result if it was published after the previous call, nullptr otherwise.
+    // The returned result stays valid until the next successful call
+    const SplineResult* acquire();
+
+    static std::unique_ptr<TV::Math::SplineFunction> generateSpline(const SplineRequest& request);
+
+    static CurveSamples generateSamples(const TV::Math::SplineFunction* spline, const SplineRequest& request);
+
+private:
+    SpscQueue<SplineRequest, 8> mRequests;
+    // bumped on every submit to wake the worker up
+    std::atomic<int> mSubmitCount{0};
+
+    std::array<SplineResult, 2> mResults;
+    std::atomic<int> mFront{0};
+    // front was published and not acquired yet: UI may still read the back slot
+    std::atomic<bool> mIsFresh{false};
+
+    std::atomic<bool> mIsRunning{true};
+    std::thread mThread;
+
+    void loop();
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+// Lock-free bounded queue for exactly one producer thread and one consumer thread.
+// One slot is kept empty to tell a full queue from an empty one.
+template<typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2, "Queue needs at least one usable slot");
+
+public:
+    // producer side, returns false if the queue is full
+    bool push(T&& value) {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        const std::size_t next = (tail + 1) % Capacity;
+        if (next == mHead.load(std::memory_order_acquire)) {
+            return false;
+        }
+        mSlots[tail] = std::move(value);
+        mTail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, returns nothing if the queue is empty
+    std::optional<T> pop() {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(mSlots[head]));
+        mHead.store((head + 1) % Capacity, std::memory_order_release);
+        return value;
+    }
+
+private:
+    std::array<T, Capacity> mSlots{};
+    // head is written by consumer only, tail by producer only: keep them on separate cache lines
+    alignas(64) std::atomic<std::size_t> mHead{0};
+    alignas(64) std::atomic<std::size_t> mTail{0};
+};